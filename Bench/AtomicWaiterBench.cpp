@@ -0,0 +1,103 @@
+/*
+** EntityCore
+** Benchmark - AtomicWaiter
+** File description:
+** Wake-up latency and throughput of the blocking WorkQueue, parked through AtomicWaiter,
+** against the same queue parked through a mutex and a condition_variable
+** Build : g++ -std=c++20 -O2 AtomicWaiterBench.cpp -o AtomicWaiterBench -lpthread
+** Usage : ./AtomicWaiterBench [round-trips] [elements]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Tools/SafeQueue.hpp"
+#include <iostream>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+
+// Blocking queue with the same interface as WorkQueue, parked through a mutex and a condition_variable
+template<class T, unsigned short capacity = 255>
+class CondVarQueue {
+public:
+    bool push(T &data) {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (!queue.push(data))
+            return false;
+        cv.notify_one();
+        return true;
+    }
+    bool pop(T &data) {
+        std::unique_lock<std::mutex> guard(mtx);
+        cv.wait(guard, [this]{return !queue.empty();});
+        return queue.pop(data);
+    }
+    void acquire() {}
+    void release() {}
+private:
+    PushQueue<T, capacity> queue;
+    std::mutex mtx;
+    std::condition_variable cv;
+};
+
+// Return the average time for a thread to wake the other one and be woken back, in nanoseconds
+template <class Queue>
+double measureRoundTrip(uint32_t roundTrips)
+{
+    auto ping = std::make_unique<Queue>();
+    auto pong = std::make_unique<Queue>();
+    std::thread echo([&]{
+        ping->acquire();
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < roundTrips; ++i) {
+            ping->pop(value);
+            pong->push(value);
+        }
+        ping->release();
+    });
+    pong->acquire();
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < roundTrips; ++i) {
+        uint32_t value = i;
+        ping->push(value);
+        pong->pop(value);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    pong->release();
+    echo.join();
+    return std::chrono::duration<double, std::nano>(end - start).count() / roundTrips;
+}
+
+// Return the number of elements per second streamed from a producer to a blocking consumer
+template <class Queue>
+double measureStream(uint32_t elements)
+{
+    auto queue = std::make_unique<Queue>();
+    std::thread consumer([&]{
+        queue->acquire();
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < elements; ++i)
+            queue->pop(value);
+        queue->release();
+    });
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < elements; ++i) {
+        uint32_t value = i;
+        while (!queue->push(value))
+            std::this_thread::yield();
+    }
+    consumer.join();
+    return elements / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t roundTrips = (argc > 1) ? std::atoi(argv[1]) : 100000;
+    const uint32_t elements = (argc > 2) ? std::atoi(argv[2]) : 10000000;
+    std::cout << "Wake-up round-trip (ns)\n";
+    std::cout << "AtomicWaiter\t" << measureRoundTrip<WorkQueue<uint32_t>>(roundTrips) << '\n';
+    std::cout << "CondVar     \t" << measureRoundTrip<CondVarQueue<uint32_t>>(roundTrips) << '\n';
+    std::cout << "Streaming throughput (M/s)\n";
+    std::cout << "AtomicWaiter\t" << measureStream<WorkQueue<uint32_t>>(elements) / 1000000 << '\n';
+    std::cout << "CondVar     \t" << measureStream<CondVarQueue<uint32_t>>(elements) / 1000000 << '\n';
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+** EntityCore
+** Benchmark - ExecutorGraph
+** File description:
+** Throughput of a frame graph of thousands of tiny nodes
+** Build : g++ -std=c++20 -O2 ExecutorGraphBench.cpp ../Executor/ExecutorGraph.cpp -o ExecutorGraphBench -lpthread
+** Usage : ./ExecutorGraphBench [threads] [frames]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Executor/ExecutorGraph.hpp"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <memory>
+
+#define LAYER_COUNT 64
+#define LAYER_WIDTH 64
+
+class TinyNode : public ExecutorNode {
+public:
+    std::atomic<uint32_t> *executed;
+protected:
+    virtual void execute() override {
+        executed->fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
+// Signal the end of a frame
+class SinkNode : public ExecutorNode {
+public:
+    std::atomic<uint32_t> frame{0};
+protected:
+    virtual void execute() override {
+        frame.fetch_add(1, std::memory_order_release);
+        frame.notify_one();
+    }
+};
+
+int main(int argc, char **argv)
+{
+    const int threadCount = (argc > 1) ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    const uint32_t frameCount = (argc > 2) ? std::atoi(argv[2]) : 1000;
+    std::atomic<uint32_t> executed{0};
+    // Each node depends on two nodes of the previous layer
+    TinyNode root;
+    root.executed = &executed;
+    root.addExternalDependency();
+    std::vector<std::unique_ptr<TinyNode>> nodes;
+    for (int l = 0; l < LAYER_COUNT; ++l) {
+        for (int w = 0; w < LAYER_WIDTH; ++w) {
+            auto node = std::make_unique<TinyNode>();
+            node->executed = &executed;
+            node->isPrioritary = (w % 8 == 0);
+            if (l == 0) {
+                node->addDependency(&root);
+            } else {
+                node->addDependency(nodes[(l - 1) * LAYER_WIDTH + w].get());
+                node->addDependency(nodes[(l - 1) * LAYER_WIDTH + (w + 1) % LAYER_WIDTH].get());
+            }
+            nodes.push_back(std::move(node));
+        }
+    }
+    SinkNode sink;
+    for (int w = 0; w < LAYER_WIDTH; ++w)
+        sink.addDependency(nodes[(LAYER_COUNT - 1) * LAYER_WIDTH + w].get());
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i)
+        threads.emplace_back(&ExecutorGraph::executeGraph, &ExecutorGraph::instance);
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t f = 0; f < frameCount; ++f) {
+        root.signalDependency();
+        sink.frame.wait(f, std::memory_order_acquire);
+    }
+    const auto end = std::chrono::steady_clock::now();
+    ExecutorGraph::instance.stop();
+    for (auto &t : threads)
+        t.join();
+
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    const uint64_t nodeCount = (uint64_t) frameCount * (nodes.size() + 2);
+    std::cout << threadCount << " threads, " << nodes.size() + 2 << " nodes per frame\n";
+    std::cout << frameCount / seconds << " frames/s, " << nodeCount / seconds / 1000000 << " M nodes/s, " << seconds * 1000000000 / nodeCount << " ns/node\n";
+    if (executed.load() + frameCount != nodeCount)
+        std::cout << "ERROR : " << executed.load() << " tiny nodes executed instead of " << nodeCount - frameCount << '\n';
+    return 0;
+}
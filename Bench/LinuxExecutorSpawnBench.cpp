@@ -0,0 +1,60 @@
+/*
+** EntityCore
+** Benchmark - LinuxExecutor spawn
+** File description:
+** Spawn rate of LinuxExecutor instances with saved output and pushed input, from an executor process of a given size
+** Build it twice to compare posix_spawn with fork :
+** g++ -std=c++20 -O2 LinuxExecutorSpawnBench.cpp ../Tools/LinuxExecutor.cpp -I../Tools -o LinuxExecutorSpawnBench -lpthread
+** g++ -std=c++20 -O2 -DLINUX_EXECUTOR_FORK LinuxExecutorSpawnBench.cpp ../Tools/LinuxExecutor.cpp -I../Tools -o LinuxExecutorSpawnBenchFork -lpthread
+** Usage : ./LinuxExecutorSpawnBench [spawns] [executor memory in MB]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Tools/LinuxExecutor.hpp"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+
+int main(int argc, char **argv)
+{
+    const int spawnCount = (argc > 1) ? std::atoi(argv[1]) : 500;
+    const size_t memory = ((argc > 2) ? std::atoi(argv[2]) : 256) << 20;
+    // Touched memory, inherited by the executor process, so fork has page tables to copy
+    char *ballast = new char[memory];
+    std::memset(ballast, 1, memory);
+    LinuxExecutor executor(0, 0);
+    executor.start(false);
+
+    const char *args[] = {"/bin/cat", nullptr};
+    char input[] = "spawn";
+    ExecutorInfo info;
+    info.args = args;
+    info.pushInput = true;
+    info.pushedInput.str = input;
+    info.pushedInput.size = sizeof(input) - 1;
+    info.saveOutput = true;
+    ExecutorContext *context = executor.create(info);
+    // Jobs are completed without polling, unlike waitInstance
+    std::vector<ExecutorContext *> jobs(spawnCount, context);
+    std::atomic<int> failures{0};
+    const auto start = std::chrono::steady_clock::now();
+    executor.submitJobs(jobs, [&](ExecutorContext *, ExecutorInstance *instance){
+        failures += (instance->exitCode != 0 || instance->output.size() != sizeof(input) - 1);
+    });
+    executor.waitJobs();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    executor.discard(context);
+    executor.close();
+    while (!executor.closed())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#ifdef LINUX_EXECUTOR_POSIX_SPAWN
+    std::cout << "posix_spawn";
+#else
+    std::cout << "fork";
+#endif
+    std::cout << ", " << (memory >> 20) << " MB executor : " << spawnCount / seconds << " spawns/s, " << seconds * 1000000 / spawnCount << " us/spawn\n";
+    if (failures)
+        std::cout << "ERROR : " << failures.load() << " instances failed\n";
+    delete[] ballast;
+    return failures != 0;
+}
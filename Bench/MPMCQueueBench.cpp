@@ -0,0 +1,38 @@
+/*
+** EntityCore
+** Benchmark - MPMCQueue
+** File description:
+** Throughput of MPMCQueue against the existing queues, in the configurations they support
+** Build : g++ -std=c++20 -O2 MPMCQueueBench.cpp -o MPMCQueueBench -lpthread
+** Usage : ./MPMCQueueBench [threads per side] [elements per producer]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Tools/SafeQueue.hpp"
+#include "QueueBench.hpp"
+#include <iostream>
+
+static void report(const char *name, int producerCount, int consumerCount, double throughput)
+{
+    std::cout << name << "\t" << producerCount << "P" << consumerCount << "C\t" << throughput / 1000000 << " M/s\n";
+}
+
+int main(int argc, char **argv)
+{
+    const int n = (argc > 1) ? std::atoi(argv[1]) : 4;
+    const uint32_t perProducer = (argc > 2) ? std::atoi(argv[2]) : 1000000;
+
+    // Single producer, single consumer
+    report("MPMCQueue", 1, 1, measureThroughput<MPMCQueue<uint64_t, 256>>(1, 1, perProducer));
+    report("PushQueue", 1, 1, measureThroughput<PushQueue<uint64_t, 255>>(1, 1, perProducer));
+    report("PopQueue ", 1, 1, measureThroughput<PopQueue<uint64_t, 255>>(1, 1, perProducer));
+    // Multiple producers, single consumer
+    report("MPMCQueue", n, 1, measureThroughput<MPMCQueue<uint64_t, 256>>(n, 1, perProducer / n));
+    report("PushQueue", n, 1, measureThroughput<PushQueue<uint64_t, 255>>(n, 1, perProducer / n));
+    // Single producer, multiple consumers
+    report("MPMCQueue", 1, n, measureThroughput<MPMCQueue<uint64_t, 256>>(1, n, perProducer));
+    report("PopQueue ", 1, n, measureThroughput<PopQueue<uint64_t, 255>>(1, n, perProducer));
+    // Multiple producers, multiple consumers, only supported by MPMCQueue
+    report("MPMCQueue", n, n, measureThroughput<MPMCQueue<uint64_t, 256>>(n, n, perProducer / n));
+    return 0;
+}
@@ -0,0 +1,62 @@
+/*
+** EntityCore
+** Benchmark - QueueBench
+** File description:
+** Shared throughput measurement of the SafeQueue family
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#ifndef QUEUE_BENCH_HPP_
+#define QUEUE_BENCH_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// Run producerCount threads pushing perProducer elements each, and consumerCount threads popping them all
+// Failed push and pop are retried after a yield, so it also works with more threads than cores
+// Return the number of transferred elements per second
+template <class Queue>
+double measureThroughput(int producerCount, int consumerCount, uint32_t perProducer)
+{
+    auto queue = std::make_unique<Queue>();
+    const uint64_t total = (uint64_t) producerCount * perProducer;
+    std::atomic<uint64_t> popped{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producerCount; ++p) {
+        threads.emplace_back([&]{
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            for (uint32_t i = 0; i < perProducer; ++i) {
+                uint64_t value = i;
+                while (!queue->push(value))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < consumerCount; ++c) {
+        threads.emplace_back([&]{
+            while (!go.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            uint64_t value;
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (queue->pop(value))
+                    popped.fetch_add(1, std::memory_order_relaxed);
+                else
+                    std::this_thread::yield();
+            }
+        });
+    }
+    const auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto &t : threads)
+        t.join();
+    return total / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+#endif /* end of include guard: QUEUE_BENCH_HPP_ */
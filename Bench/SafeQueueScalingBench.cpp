@@ -0,0 +1,32 @@
+/*
+** EntityCore
+** Benchmark - SafeQueue scaling
+** File description:
+** Throughput of the SafeQueue family from 2 to 32 threads
+** Build it twice to compare the padded layout with a packed one, where every index share a cache line :
+** g++ -std=c++20 -O2 SafeQueueScalingBench.cpp -o SafeQueueScalingBench -lpthread
+** g++ -std=c++20 -O2 -DSAFEQUEUE_CACHE_LINE=8 SafeQueueScalingBench.cpp -o SafeQueueScalingBenchPacked -lpthread
+** Usage : ./SafeQueueScalingBench [elements per configuration]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Tools/SafeQueue.hpp"
+#include "QueueBench.hpp"
+#include <iostream>
+
+int main(int argc, char **argv)
+{
+    const uint32_t elements = (argc > 1) ? std::atoi(argv[1]) : 2000000;
+    std::cout << "Cache line " << SAFEQUEUE_CACHE_LINE << ", throughput in M/s\n";
+    std::cout << "threads\tPushQueue\tPopQueue\tWorkQueue\tMPMCQueue\n";
+    for (int threads = 2; threads <= 32; threads *= 2) {
+        // PushQueue and WorkQueue have a single consumer, PopQueue a single producer
+        std::cout << threads;
+        std::cout << '\t' << measureThroughput<PushQueue<uint64_t, 255>>(threads - 1, 1, elements / (threads - 1)) / 1000000;
+        std::cout << '\t' << measureThroughput<PopQueue<uint64_t, 255>>(1, threads - 1, elements) / 1000000;
+        std::cout << '\t' << measureThroughput<WorkQueue<uint64_t, 255>>(threads - 1, 1, elements / (threads - 1)) / 1000000;
+        std::cout << '\t' << measureThroughput<MPMCQueue<uint64_t, 256>>(threads / 2, threads / 2, elements / (threads / 2)) / 1000000;
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+/*
+** EntityCore
+** Benchmark - TaskScheduler
+** File description:
+** Throughput of millions of tasks across thousands of Taskables run by a TaskScheduler, checking the order of each chain
+** Build : g++ -std=c++20 -O2 TaskSchedulerBench.cpp ../Executor/TaskScheduler.cpp -o TaskSchedulerBench -lpthread
+** Usage : ./TaskSchedulerBench [workers] [taskables] [tasks per taskable]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Executor/TaskScheduler.hpp"
+#include <iostream>
+#include <chrono>
+#include <memory>
+
+struct CountedTaskable : public Taskable {
+    uint32_t executed = 0; // Only accessed by the tasks of this chain
+    uint32_t misordered = 0;
+};
+
+static std::atomic<uint64_t> completed{0};
+
+class BenchTask : public Task {
+public:
+    uint32_t sequence; // Position of this task in its chain
+    virtual void start(Taskable *target) override {
+        auto *counted = static_cast<CountedTaskable *>(target);
+        counted->misordered += (counted->executed++ != sequence);
+        completed.fetch_add(1, std::memory_order_relaxed);
+        TaskScheduler::endTask(target, this);
+    }
+};
+
+int main(int argc, char **argv)
+{
+    const int workerCount = (argc > 1) ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    const uint32_t taskableCount = (argc > 2) ? std::atoi(argv[2]) : 2000;
+    const uint32_t taskCount = (argc > 3) ? std::atoi(argv[3]) : 1000;
+    const uint64_t total = (uint64_t) taskableCount * taskCount;
+    // Tasks are kept until the end, so their storage outlives the marker window
+    std::unique_ptr<CountedTaskable[]> taskables(new CountedTaskable[taskableCount]);
+    std::unique_ptr<BenchTask[]> tasks(new BenchTask[total]);
+
+    TaskScheduler scheduler(workerCount);
+    const auto start = std::chrono::steady_clock::now();
+    // Interleave the chains, so that many of them are active at once
+    for (uint32_t i = 0; i < taskCount; ++i) {
+        for (uint32_t j = 0; j < taskableCount; ++j) {
+            BenchTask &task = tasks[(uint64_t) j * taskCount + i];
+            task.sequence = i;
+            scheduler.submit(&taskables[j], &task);
+        }
+    }
+    while (completed.load(std::memory_order_relaxed) < total)
+        std::this_thread::yield();
+    const auto end = std::chrono::steady_clock::now();
+    scheduler.stop();
+
+    uint64_t misordered = 0;
+    for (uint32_t j = 0; j < taskableCount; ++j)
+        misordered += taskables[j].misordered;
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << workerCount << " workers, " << taskableCount << " taskables, " << total << " tasks\n";
+    std::cout << total / seconds / 1000000 << " M tasks/s, " << seconds * 1000000000 / total << " ns/task\n";
+    if (misordered)
+        std::cout << "ERROR : " << misordered << " tasks executed out of order\n";
+    return misordered != 0;
+}
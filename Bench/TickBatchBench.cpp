@@ -0,0 +1,141 @@
+/*
+** EntityCore
+** Benchmark - TickBatch
+** File description:
+** Cost per element and per tick of transiting AFader and moving ASmooth advanced by their batch, then read through their handle,
+** against the same fader ticked by a virtual update per object
+** Built with -O3, as -O2 doesn't vectorize loops of unknown trip count with GCC 12
+** Build : g++ -std=c++20 -O3 TickBatchBench.cpp -o TickBatchBench -lpthread
+** Usage : ./TickBatchBench [elements] [ticks]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Executor/TickMgr.hpp"
+#include "../Executor/AFader.hpp"
+#include "../Executor/ASmooth.hpp"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <vector>
+#include <memory>
+
+class BenchMgr : public TickMgr<BenchMgr> {
+public:
+    static inline BenchMgr *instance = nullptr;
+};
+
+struct SquareInterp {
+    float operator()(float t) const {return t * t;}
+    float one() const {return 1;}
+    float zero() const {return 0;}
+};
+
+// A fader ticked through the update list, as AFader was before its batch
+class VirtualFader : public Tickable<BenchMgr> {
+public:
+    VirtualFader(float duration) : duration(duration) {}
+    void start() {
+        state = true;
+        this->needUpdate(BenchMgr::instance);
+    }
+    virtual bool update(float deltaTime) override {
+        if ((timer += deltaTime) >= duration) {
+            timer = duration;
+            value = interpolator.one();
+            this->mgr = nullptr;
+            return true;
+        }
+        value = interpolator(timer / duration);
+        return false;
+    }
+    operator float() const {
+        return value;
+    }
+private:
+    SquareInterp interpolator;
+    float value = 0;
+    float timer = 0;
+    float duration;
+    bool state = false;
+};
+
+struct Timing {
+    double tick; // ns per element for the tick
+    double read; // ns per element for reading every value through its handle
+};
+
+static std::ostream &operator<<(std::ostream &os, const Timing &timing)
+{
+    return os << timing.tick << " + " << timing.read << " = " << timing.tick + timing.read << " ns/element/tick (tick + read)";
+}
+
+// Tick every element, then read all of them as a renderer would
+template <class Handle>
+static Timing measure(std::vector<std::unique_ptr<Handle>> &handles, uint32_t tickCount, float &sink)
+{
+    std::chrono::steady_clock::duration tick{0};
+    std::chrono::steady_clock::duration read{0};
+    for (uint32_t i = 0; i < tickCount; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        BenchMgr::instance->update(1.f / 60);
+        const auto ticked = std::chrono::steady_clock::now();
+        float sum = 0;
+        for (auto &h : handles)
+            sum += *h;
+        sink += sum;
+        const auto end = std::chrono::steady_clock::now();
+        tick += ticked - start;
+        read += end - ticked;
+    }
+    const double scale = 1000000000. / tickCount / handles.size();
+    return {std::chrono::duration<double>(tick).count() * scale, std::chrono::duration<double>(read).count() * scale};
+}
+
+// Allocate the handles in a random order, like objects created over the lifetime of an application
+template <class Handle, class Factory>
+static std::vector<std::unique_ptr<Handle>> makeHandles(uint32_t count, Factory factory)
+{
+    std::vector<std::unique_ptr<Handle>> handles(count);
+    std::vector<uint32_t> order(count);
+    for (uint32_t i = 0; i < count; ++i)
+        order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(42));
+    for (uint32_t i : order)
+        handles[i] = factory();
+    return handles;
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t count = (argc > 1) ? std::atoi(argv[1]) : 100000;
+    const uint32_t tickCount = (argc > 2) ? std::atoi(argv[2]) : 1000;
+    // Durations longer than the bench, so that every element keeps transiting
+    const float duration = tickCount;
+    auto mgr = std::make_unique<BenchMgr>();
+    BenchMgr::instance = mgr.get();
+    float sink = 0;
+
+    std::cout << count << " elements, " << tickCount << " ticks\n";
+    {
+        auto handles = makeHandles<VirtualFader>(count, [&]{return std::make_unique<VirtualFader>(duration);});
+        for (auto &h : handles)
+            h->start();
+        std::cout << "Virtual update per fader : " << measure(handles, tickCount, sink) << "\n";
+    }
+    {
+        using Fader = AFader<BenchMgr, SquareInterp>;
+        auto handles = makeHandles<Fader>(count, [&]{return std::make_unique<Fader>(false, duration);});
+        for (auto &h : handles)
+            *h = true;
+        std::cout << "AFaderBatch              : " << measure(handles, tickCount, sink) << "\n";
+    }
+    {
+        using Smooth = ASmooth<BenchMgr, float>;
+        auto handles = makeHandles<Smooth>(count, []{return std::make_unique<Smooth>(0.f);});
+        for (auto &h : handles)
+            h->set(100, duration);
+        std::cout << "ASmoothBatch             : " << measure(handles, tickCount, sink) << "\n";
+    }
+    return sink == 0; // Keep the reads alive
+}
@@ -2,10 +2,130 @@
 #define AFADER_HPP_
 
 #include "Tickable.hpp"
+#include "TickBatch.hpp"
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+template <class GlobalTickMgr, class Interp>
+class AFader;
+
+//! SoA storage of the transiting AFader of one type
+//! While transiting, the timer and the value of a fader live in its slot, they are advanced and
+//! interpolated by a vectorized loop and written back to the fader once its transition ends
+template <class GlobalTickMgr, class Interp>
+class AFaderBatch : public TickBatch {
+public:
+    using Fader = AFader<GlobalTickMgr, Interp>;
+    void insert(Fader *fader) {
+        fader->slot = owner.size();
+        owner.push_back(fader);
+        timer.push_back(fader->timer);
+        duration.push_back(fader->duration);
+        direction.push_back(fader->state ? 1.f : -1.f);
+        value.push_back(fader->value);
+        interpolator.push_back(fader->interpolator);
+        finished.push_back(false);
+    }
+    void remove(Fader *fader) {
+        copyTo(fader->slot, fader);
+        erase(fader->slot);
+    }
+    //! Apply a change of target state, duration or interpolator of a transiting fader
+    void sync(Fader *fader) {
+        duration[fader->slot] = fader->duration;
+        direction[fader->slot] = fader->state ? 1.f : -1.f;
+        interpolator[fader->slot] = fader->interpolator;
+    }
+    //! Write the timer and the value of this slot to a fader
+    void copyTo(uint32_t slot, Fader *fader) const {
+        fader->timer = timer[slot];
+        fader->value = value[slot];
+    }
+    inline float getTimer(uint32_t slot) const {
+        return timer[slot];
+    }
+    inline const float &getValue(uint32_t slot) const {
+        return value[slot];
+    }
+    virtual uint32_t size() const override {
+        return owner.size();
+    }
+    virtual void advance(float deltaTime, uint32_t begin, uint32_t end) override {
+        float *t = timer.data();
+        float *v = value.data();
+        uint32_t *f = finished.data();
+        const float *d = duration.data();
+        const float *dir = direction.data();
+        const Interp *interp = interpolator.data();
+        // Every element is interpolated, then the finished ones are given their final value
+        // Selecting between them in a single loop would move the division in a branch, which isn't vectorized
+        for (uint32_t i = begin; i < end; ++i) {
+            const float clamped = std::min(std::max(t[i] + dir[i] * deltaTime, 0.f), d[i]);
+            t[i] = clamped;
+            f[i] = (clamped == ((dir[i] > 0) ? d[i] : 0.f)); // Reached the bound it is heading to
+            v[i] = interp[i](clamped / d[i]);
+        }
+        for (uint32_t i = begin; i < end; ++i) {
+            const float last = (dir[i] > 0) ? interp[i].one() : interp[i].zero();
+            v[i] = f[i] ? last : v[i];
+        }
+    }
+    virtual void collect() override {
+        // Backward, so that erase only move elements which are not finished
+        for (uint32_t i = owner.size(); i--;) {
+            if (finished[i]) {
+                copyTo(i, owner[i]);
+                owner[i]->mgr = nullptr;
+                erase(i);
+            }
+        }
+    }
+    virtual void detach() override {
+        for (uint32_t i = 0; i < owner.size(); ++i) {
+            copyTo(i, owner[i]);
+            owner[i]->detach();
+        }
+        owner.clear();
+        timer.clear();
+        duration.clear();
+        direction.clear();
+        value.clear();
+        interpolator.clear();
+        finished.clear();
+    }
+private:
+    void erase(uint32_t slot) {
+        owner[slot] = owner.back();
+        owner[slot]->slot = slot;
+        owner.pop_back();
+        timer[slot] = timer.back();
+        timer.pop_back();
+        duration[slot] = duration.back();
+        duration.pop_back();
+        direction[slot] = direction.back();
+        direction.pop_back();
+        value[slot] = value.back();
+        value.pop_back();
+        interpolator[slot] = interpolator.back();
+        interpolator.pop_back();
+        finished[slot] = finished.back();
+        finished.pop_back();
+    }
+    std::vector<Fader *> owner;
+    std::vector<float> timer;
+    std::vector<float> duration;
+    std::vector<float> direction; // 1 when fading in, -1 when fading out
+    std::vector<float> value;
+    std::vector<Interp> interpolator;
+    std::vector<uint32_t> finished; // Set by advance, one word per element so ranges can be advanced concurrently, not a char type so it can't alias the timers
+};
 
 //! Automatic fader for use with a global tick manager
+//! While transiting, it is advanced by the AFaderBatch of its type
 template <class GlobalTickMgr, class Interp>
 class AFader : public Tickable<GlobalTickMgr> {
+    friend class AFaderBatch<GlobalTickMgr, Interp>;
 public:
     AFader(bool state = false, float duration = 2) : duration(duration)
     {
@@ -13,10 +133,47 @@ public:
         timer = state ? duration : 0;
     }
 
+    AFader(const AFader &other) : Tickable<GlobalTickMgr>(), interpolator(other.interpolator), value(other.value), timer(other.timer), duration(other.duration), state(other.state)
+    {
+        if (other.mgr) {
+            other.batch().copyTo(other.slot, this);
+            startTransition();
+        }
+    }
+
+    AFader &operator=(const AFader &other) {
+        if (this == &other)
+            return *this;
+        if (this->mgr) {
+            batch().remove(this);
+            this->mgr = nullptr;
+        }
+        interpolator = other.interpolator;
+        value = other.value;
+        timer = other.timer;
+        duration = other.duration;
+        state = other.state;
+        if (other.mgr) {
+            other.batch().copyTo(other.slot, this);
+            startTransition();
+        }
+        return *this;
+    }
+
+    ~AFader() {
+        if (this->mgr) {
+            batch().remove(this);
+            this->mgr = nullptr;
+        }
+    }
+
     inline void operator=(bool b) {
         if (state != b) {
             state = b;
-            this->needUpdate(GlobalTickMgr::instance);
+            if (this->mgr)
+                batch().sync(this);
+            else
+                startTransition();
         }
     }
 
@@ -46,7 +203,7 @@ public:
 
     inline void setNoDelay(bool b) {
         if (this->mgr) {
-            this->mgr->stopTicking(this);
+            batch().remove(this);
             this->mgr = nullptr;
         }
         state = b;
@@ -55,11 +212,12 @@ public:
     }
 
     inline float getInterstate() const {
-        return value;
+        return (this->mgr) ? batch().getValue(slot) : value;
     }
 
+    //! While transiting, the reference is only valid until the next update or change of transition
     inline operator const float&() const {
-        return value;
+        return (this->mgr) ? batch().getValue(slot) : value;
     }
 
     inline float getDuration() const {
@@ -68,30 +226,46 @@ public:
 
     inline void setDuration(float duration_) {
         duration = duration_;
-        if (state && !this->mgr)
+        if (this->mgr)
+            batch().sync(this);
+        else if (state)
             timer = duration_;
     }
 
     //! Return true if current value is interpolator.zero()
     inline bool isZero() const {
-        return timer == 0;
+        return getTimer() == 0;
     }
 
     //! Return true if current value is not interpolator.zero()
     inline bool isNonZero() const {
-        return timer > 0;
+        return getTimer() > 0;
     }
 
     inline bool isTransiting() const {
         return this->mgr != nullptr;
     }
 
+    //! While transiting, a change of interpolator apply on the next change of state or duration
     Interp interpolator;
 private:
-    float value; // Current value
-    float timer; // Current timer state
+    inline AFaderBatch<GlobalTickMgr, Interp> &batch() const {
+        return *transitBatch;
+    }
+    inline float getTimer() const {
+        return (this->mgr) ? batch().getTimer(slot) : timer;
+    }
+    inline void startTransition() {
+        this->mgr = GlobalTickMgr::instance;
+        transitBatch = &this->mgr->template getBatch<AFaderBatch<GlobalTickMgr, Interp>>();
+        transitBatch->insert(this);
+    }
+    float value; // Current value, stored in the batch while transiting
+    float timer; // Current timer state, stored in the batch while transiting
     float duration; // Transition duration
     bool state; // Target state
+    AFaderBatch<GlobalTickMgr, Interp> *transitBatch; // Batch of this->mgr, cached for reads while transiting
+    uint32_t slot; // Index in the AFaderBatch while transiting
 };
 
 #endif /* end of include guard: AFADER_HPP_ */
@@ -2,18 +2,191 @@
 #define ASMOOTH_HPP_
 
 #include "Tickable.hpp"
+#include "TickBatch.hpp"
+#include <vector>
+#include <cstdint>
+#include <cmath>
+
+template <class GlobalTickMgr, class T, float implicitDuration>
+class ASmooth;
+
+// SoA storage of the moving ASmooth of one type
+// While moving, the state and the value of a smooth live in its slot, they are advanced by vectorized loops
+// with phase transitions processed in place, and the state is written back once the movement ends
+template <class GlobalTickMgr, class T, float implicitDuration>
+class ASmoothBatch : public TickBatch {
+public:
+    using Smooth = ASmooth<GlobalTickMgr, T, implicitDuration>;
+    void insert(Smooth *smooth) {
+        smooth->slot = owner.size();
+        owner.push_back(smooth);
+        a.push_back(smooth->a);
+        b.push_back(smooth->b);
+        c.push_back(smooth->c);
+        timer.push_back(smooth->timer);
+        duration.push_back(smooth->duration);
+        nextDuration.push_back(smooth->nextDuration);
+        value.push_back(Smooth::position(smooth->a, smooth->b, smooth->c, smooth->timer));
+        finished.push_back(false);
+    }
+    void remove(Smooth *smooth) {
+        copyTo(smooth->slot, smooth);
+        erase(smooth->slot);
+    }
+    // Apply a change of movement of a moving smooth
+    void sync(Smooth *smooth) {
+        const uint32_t slot = smooth->slot;
+        a[slot] = smooth->a;
+        b[slot] = smooth->b;
+        c[slot] = smooth->c;
+        timer[slot] = smooth->timer;
+        duration[slot] = smooth->duration;
+        nextDuration[slot] = smooth->nextDuration;
+        value[slot] = Smooth::position(smooth->a, smooth->b, smooth->c, smooth->timer);
+    }
+    // Write the state of this slot to a smooth
+    void copyTo(uint32_t slot, Smooth *smooth) const {
+        smooth->a = a[slot];
+        smooth->b = b[slot];
+        smooth->c = c[slot];
+        smooth->timer = timer[slot];
+        smooth->duration = duration[slot];
+        smooth->nextDuration = nextDuration[slot];
+    }
+    inline T getValue(uint32_t slot) const {
+        return value[slot];
+    }
+    virtual uint32_t size() const override {
+        return owner.size();
+    }
+    virtual void advance(float deltaTime, uint32_t begin, uint32_t end) override {
+        float *t = timer.data();
+        const float *d = duration.data();
+        uint32_t *f = finished.data();
+        for (uint32_t i = begin; i < end; ++i) {
+            t[i] += deltaTime;
+            f[i] = (t[i] >= d[i]);
+        }
+        const T *pa = a.data();
+        const T *pb = b.data();
+        const T *pc = c.data();
+        T *v = value.data();
+        for (uint32_t i = begin; i < end; ++i)
+            v[i] = Smooth::position(pa[i], pb[i], pc[i], t[i]);
+        for (uint32_t i = begin; i < end; ++i) {
+            // End of a movement phase, rare enough to be processed by the scalar path
+            if (f[i]) {
+                f[i] = Smooth::endPhase(a[i], b[i], c[i], t[i], duration[i], nextDuration[i]);
+                v[i] = f[i] ? c[i] : Smooth::position(a[i], b[i], c[i], t[i]);
+            }
+        }
+    }
+    virtual void collect() override {
+        // Backward, so that erase only move elements which are not finished
+        for (uint32_t i = owner.size(); i--;) {
+            if (finished[i]) {
+                copyTo(i, owner[i]);
+                owner[i]->mgr = nullptr;
+                erase(i);
+            }
+        }
+    }
+    virtual void detach() override {
+        for (uint32_t i = 0; i < owner.size(); ++i) {
+            copyTo(i, owner[i]);
+            owner[i]->detach();
+        }
+        owner.clear();
+        a.clear();
+        b.clear();
+        c.clear();
+        timer.clear();
+        duration.clear();
+        nextDuration.clear();
+        value.clear();
+        finished.clear();
+    }
+private:
+    void erase(uint32_t slot) {
+        owner[slot] = owner.back();
+        owner[slot]->slot = slot;
+        owner.pop_back();
+        a[slot] = a.back();
+        a.pop_back();
+        b[slot] = b.back();
+        b.pop_back();
+        c[slot] = c.back();
+        c.pop_back();
+        timer[slot] = timer.back();
+        timer.pop_back();
+        duration[slot] = duration.back();
+        duration.pop_back();
+        nextDuration[slot] = nextDuration.back();
+        nextDuration.pop_back();
+        value[slot] = value.back();
+        value.pop_back();
+        finished[slot] = finished.back();
+        finished.pop_back();
+    }
+    std::vector<Smooth *> owner;
+    std::vector<T> a;
+    std::vector<T> b;
+    std::vector<T> c;
+    std::vector<float> timer;
+    std::vector<float> duration;
+    std::vector<float> nextDuration;
+    std::vector<T> value;
+    std::vector<uint32_t> finished; // Set by advance, one word per element so ranges can be advanced concurrently, not a char type so it can't alias the timers
+};
 
 // A value smoothly changing, using optimal acceleration and deceleration
-// Size in memory in octect is (float: 40, double: 56, long double: 80)
-template <class GlobalTickMgr, class T = float, float implicitDuration=0.5>
+// Size in memory in octect is (float: 64, double: 80, long double: 112)
+template <class GlobalTickMgr, class T = float, float implicitDuration=0.5f>
 class ASmooth : public Tickable<GlobalTickMgr> {
+    friend class ASmoothBatch<GlobalTickMgr, T, implicitDuration>;
 public:
     ASmooth(T value) : c(value)
     {
     }
 
+    ASmooth(const ASmooth &other) : Tickable<GlobalTickMgr>(), a(other.a), b(other.b), c(other.c), timer(other.timer), duration(other.duration), nextDuration(other.nextDuration)
+    {
+        if (other.mgr) {
+            other.batch().copyTo(other.slot, this);
+            startMovement();
+        }
+    }
+
+    ASmooth &operator=(const ASmooth &other) {
+        if (this == &other)
+            return *this;
+        if (this->mgr) {
+            batch().remove(this);
+            this->mgr = nullptr;
+        }
+        a = other.a;
+        b = other.b;
+        c = other.c;
+        timer = other.timer;
+        duration = other.duration;
+        nextDuration = other.nextDuration;
+        if (other.mgr) {
+            other.batch().copyTo(other.slot, this);
+            startMovement();
+        }
+        return *this;
+    }
+
+    ~ASmooth() {
+        if (this->mgr) {
+            batch().remove(this);
+            this->mgr = nullptr;
+        }
+    }
+
     inline void set(T dst, float minDuration) {
         if (this->mgr) {
+            batch().copyTo(slot, this);
             {
                 const float tmp = duration + nextDuration;
                 if (minDuration < tmp)
@@ -38,6 +211,7 @@ public:
                 timer = 0;
                 duration = nextDuration = minDuration / 2;
                 a = (dst/2) / (duration*duration);
+                batch().sync(this);
                 return;
             }
             // Calculate new coefficients to preserve both position and velocity
@@ -52,12 +226,14 @@ public:
             timer = 0;
             duration = accelerationTime;
             nextDuration = minDuration - duration;
+            batch().sync(this);
         } else if (minDuration) {
             duration = nextDuration = minDuration / 2;
             dst -= c; // Dst now represent the delta
             a = (dst/2) / (duration*duration);
             b = 0;
-            this->needUpdate(GlobalTickMgr::instance);
+            timer = 0;
+            startMovement();
         } else {
             c = dst;
         }
@@ -72,20 +248,7 @@ public:
     }
 
     virtual bool update(float deltaTime) override {
-        if ((timer += deltaTime) >= duration) {
-            c += duration * (b + duration * a);
-            if (nextDuration) { // Compose next movement
-                b += duration * a*2;
-                a = -a;
-                // Carry-over must use the FINISHED phase's duration - it was
-                // computed after the overwrite (off by d1-d2 wall-time after
-                // a retarget; zero for fresh movements where d1==d2).
-                deltaTime = timer - duration;
-                duration = nextDuration;
-                nextDuration = 0;
-                timer = 0;
-                return update(deltaTime);
-            }
+        if ((timer += deltaTime) >= duration && endPhase(a, b, c, timer, duration, nextDuration)) {
             this->mgr = nullptr;
             return true;
         }
@@ -93,16 +256,49 @@ public:
     }
 
     inline operator T() const {
+        return (this->mgr) ? batch().getValue(slot) : c;
+    }
+private:
+    static inline T position(T a, T b, T c, float timer) {
         // p(t) = (a*t + b)*t + c - the previous parenthesization
         // ((a*t) + b*t) + c collapsed the quadratic term to linear
         // (display-only: committed state was unaffected, exact at phase ends).
-        return (this->mgr) ? (((a * timer) + b) * timer + c) : c;
+        return ((a * timer) + b) * timer + c;
     }
-private:
+    // Complete the phases ended by the timer, return true if the movement is complete
+    // Shared by update() and ASmoothBatch, which keeps this state while moving
+    static inline bool endPhase(T &a, T &b, T &c, float &timer, float &duration, float &nextDuration) {
+        while (timer >= duration) {
+            c += duration * (b + duration * a);
+            if (!nextDuration)
+                return true;
+            // Compose next movement
+            b += duration * a*2;
+            a = -a;
+            // Carry-over must use the FINISHED phase's duration - it was
+            // computed after the overwrite (off by d1-d2 wall-time after
+            // a retarget; zero for fresh movements where d1==d2).
+            timer -= duration;
+            duration = nextDuration;
+            nextDuration = 0;
+        }
+        return false;
+    }
+    inline ASmoothBatch<GlobalTickMgr, T, implicitDuration> &batch() const {
+        return *transitBatch;
+    }
+    inline void startMovement() {
+        this->mgr = GlobalTickMgr::instance;
+        transitBatch = &this->mgr->template getBatch<ASmoothBatch<GlobalTickMgr, T, implicitDuration>>();
+        transitBatch->insert(this);
+    }
+    // Stored in the batch while moving
     T a, b, c; // Coefficients of the current equation
     float timer;
     float duration;
     float nextDuration;
+    ASmoothBatch<GlobalTickMgr, T, implicitDuration> *transitBatch; // Batch of this->mgr, cached for reads while moving
+    uint32_t slot; // Index in the ASmoothBatch while moving
 };
 
 #endif /* end of include guard: ASMOOTH_HPP_ */
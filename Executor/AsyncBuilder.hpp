@@ -20,6 +20,7 @@ public:
     }
 
     std::atomic<LoadPriority> priority;
+    LoadPriority servedPriority = LoadPriority::DONE; // Priority at the time the building started, order postLoad()
     std::atomic<uint32_t> useCount{1U};
 };
 
@@ -5,6 +5,7 @@
 #include <filesystem>
 
 class SaveData;
+class AsyncBuilder;
 
 #ifdef __linux__
 #define AL_FILE int
@@ -28,7 +29,13 @@ public:
 
     const std::filesystem::path source;
     LoadPriority priority;
+    LoadPriority servedPriority = LoadPriority::DONE; // Priority at the time the loading started, order postLoad()
     bool once = true; // True if this file will be read only once with large reads
+    AsyncBuilder *chained = nullptr; // Builder started by the loader thread as soon as loadCache has returned
+    // Internal state of shared loads - accessed in AsyncLoaderMgr.cpp
+    uint32_t useCount = 0; // Number of owners of this shared load
+    bool shared = false; // True if this loader is owned by the AsyncLoaderMgr
+    bool listed = false; // True while this loader is in the loader list
 };
 
 #endif /* end of include guard: ASYNC_LOADER_HPP_ */
@@ -1,6 +1,7 @@
 #include "AsyncLoaderMgr.hpp"
 #include "AsyncLoader.hpp"
 #include "AsyncBuilder.hpp"
+#include <algorithm>
 
 #ifdef __linux__
 #include <unistd.h>
@@ -22,6 +23,11 @@ AsyncLoaderMgr::AsyncLoaderMgr(const std::filesystem::path &dataPath, const std:
 AsyncLoaderMgr::~AsyncLoaderMgr()
 {
     stop();
+    for (auto task : loaders) {
+        task->listed = false;
+        if (task->shared && task->useCount == 0)
+            discardShared(task);
+    }
     instance = nullptr;
 }
 
@@ -32,8 +38,14 @@ void AsyncLoaderMgr::stop()
     if (thread.joinable()) {
         cv.notify_all();
         thread.join();
-        for (auto task : loaders)
+        for (auto task : loaders) {
             task->priority = LoadPriority::DONE;
+            if (task->chained) {
+                task->chained->priority.store(LoadPriority::DONE, std::memory_order_relaxed);
+                task->chained->detach();
+                task->chained = nullptr;
+            }
+        }
     }
     if (!threads.empty()) {
         for (auto &t : threads)
@@ -48,15 +60,98 @@ void AsyncLoaderMgr::stop()
 
 void AsyncLoaderMgr::addLoad(AsyncLoader *task)
 {
+    task->listed = true;
     loaders.push_front(task);
     if (paused && task->priority > minPriority)
         cv.notify_one();
 }
 
+void AsyncLoaderMgr::addLoad(AsyncLoader *task, AsyncBuilder *then)
+{
+    then->useCount.fetch_add(1, std::memory_order_relaxed);
+    task->chained = then;
+    addLoad(task);
+}
+
+AsyncLoader *AsyncLoaderMgr::addSharedLoad(AsyncLoader *task)
+{
+    auto &entry = sharedLoaders[task->source.string()];
+    if (entry) {
+        // Coalesce onto the pending or loaded request, raising its priority if needed
+        while (loadersLock.test_and_set())
+            std::this_thread::yield();
+        if (entry->priority > LoadPriority::LOADING && entry->priority < task->priority)
+            entry->priority = task->priority;
+        loadersLock.clear();
+        if (paused && entry->priority > minPriority)
+            cv.notify_one();
+        delete task;
+        ++entry->useCount;
+        return entry;
+    }
+    entry = task;
+    task->shared = true;
+    task->useCount = 1;
+    addLoad(task);
+    return task;
+}
+
+void AsyncLoaderMgr::releaseLoad(AsyncLoader *task)
+{
+    if (--task->useCount)
+        return;
+    if (task->listed) {
+        // Deleted once removed from the list
+        cancelLoad(task);
+    } else
+        discardShared(task);
+}
+
+bool AsyncLoaderMgr::cancelLoad(AsyncLoader *task)
+{
+    // The loader thread switch to LOADING while holding loadersLock
+    while (loadersLock.test_and_set())
+        std::this_thread::yield();
+    const bool cancelled = (task->priority > LoadPriority::LOADING);
+    if (cancelled)
+        task->priority = LoadPriority::DONE;
+    loadersLock.clear();
+    if (cancelled) {
+        if (task->chained) {
+            task->chained->priority.store(LoadPriority::DONE, std::memory_order_relaxed);
+            task->chained->detach();
+            task->chained = nullptr;
+        }
+        if (task->shared) {
+            // Further requests of this source must perform a new load
+            auto it = sharedLoaders.find(task->source.string());
+            if (it != sharedLoaders.end() && it->second == task)
+                sharedLoaders.erase(it);
+        }
+    }
+    return cancelled;
+}
+
+void AsyncLoaderMgr::discardShared(AsyncLoader *task)
+{
+    auto it = sharedLoaders.find(task->source.string());
+    if (it != sharedLoaders.end() && it->second == task)
+        sharedLoaders.erase(it);
+    delete task;
+}
+
 void AsyncLoaderMgr::addBuild(AsyncBuilder *task)
 {
     task->useCount.fetch_add(1, std::memory_order_relaxed);
+    insertBuild(task);
+}
+
+void AsyncLoaderMgr::insertBuild(AsyncBuilder *task)
+{
+    while (buildersLock.test_and_set())
+        std::this_thread::yield();
     builders.push_front(task);
+    buildersLock.clear();
     if (task->priority.load(std::memory_order_relaxed) > minPriority)
         cvBuilder.notify_one();
 }
@@ -71,56 +166,65 @@ std::ofstream AsyncLoaderMgr::setBinCache(SaveData &cache)
    return file;
 }
 
-void AsyncLoaderMgr::update()
+void AsyncLoaderMgr::update(std::chrono::microseconds budget)
 {
-    if (!loaders.empty()) {
-        if (loadersLock.test_and_set()) {
-            for (auto task : loaders) {
-                if (task->priority == LoadPriority::COMPLETED) {
-                    task->postLoad();
-                    task->priority = LoadPriority::DONE;
-                }
-            }
-        } else {
-            loaders.remove_if([](AsyncLoader *task){
-                switch (task->priority) {
-                    case LoadPriority::COMPLETED:
-                        task->postLoad();
-                        task->priority = LoadPriority::DONE;
-                        [[fallthrough]];
-                    case LoadPriority::DONE:
-                        return true;
-                    default:
-                        return false;
-                }
-            });
-            loadersLock.clear();
+    const auto start = std::chrono::steady_clock::now();
+    const auto deadline = (budget == std::chrono::microseconds::max()) ? std::chrono::steady_clock::time_point::max() : start + budget;
+
+    // Gather completed tasks
+    for (auto task : loaders) {
+        if (task->priority == LoadPriority::COMPLETED)
+            completed.push_back({task->servedPriority, task, nullptr});
+    }
+    // If a builder is being inserted, completed builders are gathered by the next update
+    if (!buildersLock.test_and_set()) {
+        for (auto task : builders) {
+            if (task->priority.load(std::memory_order_acquire) == LoadPriority::COMPLETED)
+                completed.push_back({task->servedPriority, nullptr, task});
         }
+        buildersLock.clear();
     }
-    if (!builders.empty()) {
-        if (buildersLock.test_and_set()) {
-            for (auto task : builders) {
-                if (task->priority.load(std::memory_order_acquire) == LoadPriority::COMPLETED) {
-                    task->postLoad();
-                    task->priority = LoadPriority::DONE;
-                }
-            }
+    // Finalize them by decreasing priority, at least one is processed per update
+    std::stable_sort(completed.begin(), completed.end(), [](const CompletedTask &a, const CompletedTask &b){
+        return a.priority > b.priority;
+    });
+    auto it = completed.begin();
+    while (it != completed.end()) {
+        if (it->loader) {
+            it->loader->postLoad();
+            it->loader->priority = LoadPriority::DONE;
         } else {
-            builders.remove_if([](AsyncBuilder *task){
-                switch (task->priority.load(std::memory_order_acquire)) {
-                    case LoadPriority::COMPLETED:
-                        task->postLoad();
-                        task->priority.store(LoadPriority::DONE, std::memory_order_release);
-                        [[fallthrough]];
-                    case LoadPriority::DONE:
-                        task->detach();
-                        return true;
-                    default:
-                        return false;
-                }
-            });
-            buildersLock.clear();
+            it->builder->postLoad();
+            it->builder->priority.store(LoadPriority::DONE, std::memory_order_release);
         }
+        if (++it != completed.end() && std::chrono::steady_clock::now() >= deadline)
+            break;
+    }
+    deferredCount = completed.end() - it;
+    deferredTotal += deferredCount;
+    completed.clear();
+
+    // Remove finished tasks
+    if (!loaders.empty() && !loadersLock.test_and_set()) {
+        loaders.remove_if([this](AsyncLoader *task){
+            if (task->priority != LoadPriority::DONE)
+                return false;
+            task->listed = false;
+            if (task->shared && task->useCount == 0)
+                discardShared(task);
+            return true;
+        });
+        loadersLock.clear();
+    }
+    if (!buildersLock.test_and_set()) {
+        builders.remove_if([](AsyncBuilder *task){
+            if (task->priority.load(std::memory_order_relaxed) == LoadPriority::DONE) {
+                task->detach();
+                return true;
+            }
+            return false;
+        });
+        buildersLock.clear();
     }
 }
 
@@ -142,9 +246,11 @@ void AsyncLoaderMgr::threadloop()
                 task = t;
             }
         }
+        if (task)
+            task->priority = LoadPriority::LOADING; // Done while locked, so cancelLoad can't miss it
         loadersLock.clear();
         if (task) {
-            task->priority = LoadPriority::LOADING;
+            task->servedPriority = taskPriority;
             auto &cache = getCache(task->source);
             if (cache.checkCache(task->source))
                 task->generateCache(cache);
@@ -165,6 +271,11 @@ void AsyncLoaderMgr::threadloop()
                 task->loadCache(cache, &file);
                 #endif
             }
+            if (task->chained) {
+                // Start the post-processing now, the main thread only see the builder through update()
+                insertBuild(task->chained);
+                task->chained = nullptr;
+            }
             task->priority = LoadPriority::COMPLETED;
         } else {
             paused = true;
@@ -180,11 +291,17 @@ bool AsyncLoaderMgr::isTaskWithPriority(LoadPriority priority)
         if (t->priority >= priority)
             return true;
     }
+    bool found = false;
+    while (buildersLock.test_and_set())
+        std::this_thread::yield();
     for (auto t : builders) {
-        if (t->priority.load(std::memory_order_relaxed) >= priority)
-            return true;
+        if (t->priority.load(std::memory_order_relaxed) >= priority) {
+            found = true;
+            break;
+        }
     }
-    return false;
+    buildersLock.clear();
+    return found;
 }
 
 void AsyncLoaderMgr::builderThreadLoop()
@@ -207,6 +324,7 @@ void AsyncLoaderMgr::builderThreadLoop()
         }
         buildersLock.clear();
         if (task) {
+            task->servedPriority = taskPriority;
             task->priority.store(LoadPriority::LOADING, std::memory_order_relaxed);
             task->asyncLoad();
             task->priority.store(LoadPriority::COMPLETED, std::memory_order_release);
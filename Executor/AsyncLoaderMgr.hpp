@@ -9,6 +9,9 @@
 #include <condition_variable>
 #include <fstream>
 #include <list>
+#include <unordered_map>
+#include <vector>
+#include <chrono>
 
 class AsyncLoader;
 class AsyncBuilder;
@@ -30,9 +33,28 @@ public:
     void stop();
 
     void addLoad(AsyncLoader *task);
+    // Add a loader whose completion directly submit the builder, without waiting for update()
+    // The builder asyncLoad() may run before the postLoad() of the loader
+    void addLoad(AsyncLoader *task, AsyncBuilder *then);
     void addBuild(AsyncBuilder *task);
+    // Add a loader shared by every request of the same source, return the loader in charge of this source
+    // If another shared loader of this source is pending or loaded, task is deleted and this loader is returned
+    // The returned loader is owned by the AsyncLoaderMgr and must be released with releaseLoad
+    // Shared loads must be added and released from the thread calling update()
+    AsyncLoader *addSharedLoad(AsyncLoader *task);
+    // Release a loader returned by addSharedLoad, cancel it if it was the last owner and it has not started loading
+    void releaseLoad(AsyncLoader *task);
+    // Cancel a loader which has not started loading yet, return true on success
+    // On success, it is removed from the list on the next update and postLoad() is never called
+    bool cancelLoad(AsyncLoader *task);
 
-    void update();
+    // Run postLoad() of every completed task
+    inline void update() {
+        update(std::chrono::microseconds::max());
+    }
+    // Run postLoad() of completed tasks by decreasing priority until the budget has expired
+    // Remaining completed tasks are carried to the next update
+    void update(std::chrono::microseconds budget);
     inline void flush() {
         if (paused)
             cv.notify_one();
@@ -58,20 +80,35 @@ public:
 
     // Highest priority of AsyncLoader to ignore
     LoadPriority minPriority = LoadPriority::BACKGROUND;
+    // Number of completed tasks carried by the last update to the next one
+    uint32_t deferredCount = 0;
+    // Total number of times a completed task has been carried to the next update
+    uint64_t deferredTotal = 0;
     static AsyncLoaderMgr *instance;
 private:
+    struct CompletedTask {
+        LoadPriority priority;
+        AsyncLoader *loader;
+        AsyncBuilder *builder;
+    };
     void threadloop();
     void builderThreadLoop();
+    // Insert a builder, this may be called from the loader thread
+    void insertBuild(AsyncBuilder *task);
+    // Delete a shared loader which is no longer listed nor owned
+    void discardShared(AsyncLoader *task);
     std::thread thread; // Loader thread
     std::vector<std::thread> threads; // Builder threads
     std::list<AsyncLoader *> loaders;
     std::atomic_flag loadersLock; // Ensure the list is not modified while it is accessed
+    std::unordered_map<std::string, AsyncLoader *> sharedLoaders; // Shared loaders per source
     std::condition_variable cv;
     const std::filesystem::path dataPath;
     const std::filesystem::path cachePath;
     std::list<AsyncBuilder *> builders;
     std::atomic_flag buildersLock; // Ensure the list is not modified while it is accessed
     std::condition_variable cvBuilder;
+    std::vector<CompletedTask> completed; // Completed tasks of the current update, kept to reuse the allocation
     BigSave sd;
     bool alive = true;
     bool paused = false;
@@ -0,0 +1,87 @@
+#include "ExecutorGraph.hpp"
+#include <thread>
+
+ExecutorGraph ExecutorGraph::instance;
+
+ExecutorGraph::ExecutorGraph() : semaphore(0)
+{
+}
+
+void ExecutorGraph::Queue::push(ExecutorNode *node)
+{
+    pending[writeIdx.fetch_add(1, std::memory_order_relaxed)].store(node, std::memory_order_release);
+}
+
+ExecutorNode *ExecutorGraph::Queue::pop()
+{
+    auto &slot = pending[readIdx.fetch_add(1, std::memory_order_relaxed)];
+    ExecutorNode *node;
+    // The slot may have been reserved by a push which hasn't written it yet
+    while (!(node = slot.exchange(nullptr, std::memory_order_acquire)))
+        std::this_thread::yield();
+    return node;
+}
+
+void ExecutorGraph::executeNode(ExecutorNode *node)
+{
+    if (node->isPrioritary) {
+        prioritary.push(node);
+        prioritaryCount.fetch_add(1, std::memory_order_release);
+    } else
+        normal.push(node);
+    semaphore.release();
+}
+
+void ExecutorGraph::executeGraph()
+{
+    threadCount.fetch_add(1, std::memory_order_relaxed);
+    while (true) {
+        semaphore.acquire();
+        if (!alive.load(std::memory_order_relaxed))
+            break;
+        // Claim a prioritary node if there is one, a normal node otherwise
+        int count = prioritaryCount.load(std::memory_order_relaxed);
+        while (count > 0 && !prioritaryCount.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed));
+        run((count > 0) ? prioritary.pop() : normal.pop());
+    }
+    threadCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ExecutorGraph::stop()
+{
+    alive.store(false, std::memory_order_relaxed);
+    semaphore.release(threadCount.load(std::memory_order_relaxed));
+}
+
+void ExecutorGraph::start()
+{
+    alive.store(true, std::memory_order_relaxed);
+}
+
+void ExecutorGraph::run(ExecutorNode *node)
+{
+    do {
+        // Re-arm dependencies for the next execution
+        node->pendingDependencyCount.fetch_add(node->dependencyCount, std::memory_order_relaxed);
+        if (!node->skipExecution)
+            node->execute();
+        // Continue with a ready dependant instead of going through the queue, a prioritary one if any
+        ExecutorNode *next = nullptr;
+        for (auto dependant : node->dependants) {
+            if (dependant->pendingDependencyCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (!next || (dependant->isPrioritary && !next->isPrioritary)) {
+                    if (next)
+                        executeNode(next);
+                    next = dependant;
+                } else
+                    executeNode(dependant);
+            }
+        }
+        // A normal node mustn't be executed while prioritary nodes are waiting
+        if (next && !next->isPrioritary && prioritaryCount.load(std::memory_order_relaxed) > 0) {
+            executeNode(next);
+            next = nullptr;
+        }
+        node = next;
+    } while (node);
+}
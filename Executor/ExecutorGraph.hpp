@@ -1,29 +1,54 @@
 #ifndef EXECUTOR_GRAPH_HPP_
 #define EXECUTOR_GRAPH_HPP_
 
+#include "ExecutorNode.hpp"
 #include <atomic>
 #include <semaphore>
-class ExecutorNode;
 
 // Note : must be one of (uint8_t, uint16_t), as uint32_t would need 32GB
 #define PENDING_NODES_INDEX_TYPE uint16_t
 #define MAX_PENDING_NODES (1L << (8 * sizeof(PENDING_NODES_INDEX_TYPE)))
 
+// Execute nodes as soon as their dependencies are completed, on every thread calling executeGraph()
+// There must be less than MAX_PENDING_NODES nodes pending in each queue
 class ExecutorGraph {
 public:
-    // Enfore executing the node given as argument, this ma
+    // Enforce executing the node given as argument, regardless of its dependencies
     void executeNode(ExecutorNode *node);
     // Execute the graph using current thread, only return when the graph is stopped
     void executeGraph();
+    // Stop the graph, every executeGraph() return once their current node has completed
+    // Nodes still pending are not executed until the graph is started again
+    void stop();
+    // Allow executing the graph again after stop(), once every executeGraph() has returned
+    void start();
 
     // There is always a unique instance of this executor
-    ExecutorGraph instance;
+    static ExecutorGraph instance;
 private:
     ExecutorGraph();
-    std::counting_semaphore<MAX_PENDING_NODES-1> semaphore;
-    std::atomic<PENDING_NODES_INDEX_TYPE> readIdx;
-    std::atomic<PENDING_NODES_INDEX_TYPE> writeIdx;
-    ExecutorNode *pending[MAX_PENDING_NODES];
+    // Execute this node and the dependants it has made ready
+    void run(ExecutorNode *node);
+    struct Queue {
+        std::atomic<PENDING_NODES_INDEX_TYPE> readIdx{0};
+        std::atomic<PENDING_NODES_INDEX_TYPE> writeIdx{0};
+        std::atomic<ExecutorNode *> pending[MAX_PENDING_NODES];
+        void push(ExecutorNode *node);
+        ExecutorNode *pop();
+    };
+    // Each release is a node submitted to one of the queues
+    std::counting_semaphore<2 * MAX_PENDING_NODES> semaphore;
+    std::atomic<int> prioritaryCount{0}; // Number of unclaimed nodes in the prioritary queue
+    std::atomic<int> threadCount{0}; // Number of threads executing the graph
+    std::atomic<bool> alive{true};
+    Queue prioritary;
+    Queue normal;
 };
 
+inline void ExecutorNode::signalDependency()
+{
+    if (pendingDependencyCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        ExecutorGraph::instance.executeNode(this);
+}
+
 #endif /* end of include guard: EXECUTOR_GRAPH_HPP_ */
@@ -2,19 +2,23 @@
 #define EXECUTOR_NODE_HPP_
 
 #include <atomic>
-#include <semaphore>
+#include <vector>
+#include <cstdint>
 class ExecutorGraph;
 
+// A node of the frame task graph, executed once all its dependencies have been signaled
+// After each execution, the dependencies of the node are re-armed for the next execution
 class ExecutorNode {
     friend class ExecutorGraph; // Because ExecutorGraph handle the whole execution of nodes
 public:
+    virtual ~ExecutorNode() = default;
     // Add a dependency to the completion of the execution of a given node
     void addDependency(ExecutorNode *dependsOn) {
         dependsOn->dependants.push_back(this);
         ++dependencyCount;
         pendingDependencyCount.fetch_add(1, std::memory_order_relaxed);
     }
-    // Like addDependency, excepted that the dependency is not
+    // Like addDependency, excepted that the dependency is not effective for the current execution
     void addFutureDependency(ExecutorNode *willDependsOn) {
         willDependsOn->dependants.push_back(this);
         ++dependencyCount;
@@ -28,21 +32,19 @@ public:
         ++dependencyCount;
         pendingDependencyCount.fetch_add(1, std::memory_order_relaxed);
     }
-    void signalDependency() {
-        if (pendingDependencyCount.fetch_sub(1, std::memory_order_relaxed) == 1)
-            ExecutorGraph::instance->
-    }
+    // Signal a dependency of this node as completed, submit this node once every dependency is
+    inline void signalDependency();
+    // If true, execute() will be skipped, but dependants nodes will be signaled as usual
+    bool skipExecution = false;
+    // If true, this node enter in the prioritary queue which is executed before the other queue
+    bool isPrioritary = false;
 protected:
     virtual void execute() {}
+private:
     uint16_t dependencyCount = 0;
-    uint8_t priority
-    std::atomic<uint16_t> pendingDependencyCount;
-    // List of all dependencies
+    std::atomic<uint16_t> pendingDependencyCount{0};
+    // List of all nodes depending on this one
     std::vector<ExecutorNode *> dependants;
-    // If false, execute() will be skipped, but dependants nodes will be signaled as usual
-    bool skipExecution;
-    // If true, this node enter in the prioritary queue which is executed before this queue
-    bool isPrioritary = false;
 };
 
 #endif /* end of include guard: EXECUTOR_NODE_HPP_ */
@@ -9,7 +9,13 @@ class Taskable;
 class Task {
     friend class Taskable;
 public:
+    virtual ~Task() = default;
     virtual void start(Taskable *target) = 0;
+    // Return true once the storage of this task can be reused or destroyed, after its endTask
+    inline bool reclaimable() const {
+        return reclaimFlag.load(std::memory_order_acquire);
+    }
 private:
     std::atomic<Task *> next = nullptr;
+    std::atomic<bool> reclaimFlag = false;
 };
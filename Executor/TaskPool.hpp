@@ -0,0 +1,68 @@
+#pragma once
+#include "Task.hpp"
+#include <deque>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// Per-thread pool of tasks of type T, avoiding the allocator for high-rate task submission.
+// Released tasks are recycled once reclaimable. Threads exchange them by batches of
+// TASK_POOL_BATCH_SIZE through a shared list, so tasks released by worker threads are
+// reused by producer threads.
+#define TASK_POOL_BATCH_SIZE 64
+
+template <class T>
+class TaskPool {
+public:
+    // Construct a task, reusing the storage of the oldest released task if it is reclaimable
+    template <class... Args>
+    static T *acquire(Args&&... args) {
+        auto &tasks = local.tasks;
+        if (tasks.empty())
+            shared.transfer(shared.tasks, tasks);
+        if (!tasks.empty() && tasks.front()->reclaimable()) {
+            T *task = tasks.front();
+            tasks.pop_front();
+            task->~T();
+            return ::new (task) T(std::forward<Args>(args)...);
+        }
+        return new T(std::forward<Args>(args)...);
+    }
+    // Give back a task once its endTask has been called, it may still be in the marker window
+    static void release(T *task) {
+        auto &tasks = local.tasks;
+        tasks.push_back(task);
+        if (tasks.size() >= 2 * TASK_POOL_BATCH_SIZE)
+            shared.transfer(tasks, shared.tasks);
+    }
+private:
+    struct SharedList {
+        std::deque<T *> tasks;
+        std::mutex mtx;
+        // Move up to TASK_POOL_BATCH_SIZE of the oldest tasks from src to dst
+        void transfer(std::deque<T *> &src, std::deque<T *> &dst) {
+            std::lock_guard<std::mutex> lock(mtx);
+            for (int i = 0; i < TASK_POOL_BATCH_SIZE && !src.empty(); ++i) {
+                dst.push_back(src.front());
+                src.pop_front();
+            }
+        }
+        ~SharedList() {
+            // Tasks still in the marker window on exit are leaked rather than corrupted
+            for (T *task : tasks) {
+                if (task->reclaimable())
+                    delete task;
+            }
+        }
+    };
+    struct LocalList {
+        std::deque<T *> tasks;
+        ~LocalList() {
+            // Hand remaining tasks to the other threads
+            while (!tasks.empty())
+                shared.transfer(tasks, shared.tasks);
+        }
+    };
+    static inline SharedList shared;
+    static inline thread_local LocalList local;
+};
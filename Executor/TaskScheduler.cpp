@@ -0,0 +1,73 @@
+#include "TaskScheduler.hpp"
+#include <cassert>
+
+TaskScheduler *TaskScheduler::instance = nullptr;
+thread_local unsigned int TaskScheduler::depth = 0;
+
+TaskScheduler::TaskScheduler(int workerCount, unsigned int maxBurst) :
+    maxBurst(maxBurst)
+{
+    assert(!instance);
+    instance = this;
+    while (workerCount--)
+        workers.push_back(std::thread(&TaskScheduler::workerloop, this));
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    stop();
+    instance = nullptr;
+}
+
+void TaskScheduler::start(Taskable *target, Task *task)
+{
+    mtx.lock();
+    requests.push_back({target, task});
+    mtx.unlock();
+    cv.notify_one();
+}
+
+void TaskScheduler::endTask(Taskable *target, Task *task)
+{
+    if (!instance) {
+        // No pool to hand the successor to, complete it like Taskable::endTask
+        target->endTask(task);
+        return;
+    }
+    if (Task *next = target->completeTask(task)) {
+        if (depth < instance->maxBurst) {
+            ++depth;
+            next->start(target);
+            --depth;
+        } else
+            instance->start(target, next);
+    }
+}
+
+void TaskScheduler::stop()
+{
+    mtx.lock();
+    alive = false;
+    mtx.unlock();
+    cv.notify_all();
+    for (auto &t : workers)
+        t.join();
+    workers.clear();
+}
+
+void TaskScheduler::workerloop()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (true) {
+        if (!requests.empty()) {
+            auto request = requests.front();
+            requests.pop_front();
+            lock.unlock();
+            request.task->start(request.target);
+            lock.lock();
+        } else if (alive) {
+            cv.wait(lock);
+        } else
+            return;
+    }
+}
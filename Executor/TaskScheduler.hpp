@@ -0,0 +1,45 @@
+#pragma once
+#include "Taskable.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+// The place where external starts happen: run Taskable chains needing an external start
+// on a fixed pool of worker threads.
+// Chains advanced through TaskScheduler::endTask are bounded in burst: past maxBurst nested
+// synchronous completions, the successor is handed back to the pool instead of recursing.
+class TaskScheduler {
+public:
+    TaskScheduler(int workerCount, unsigned int maxBurst = 64);
+    ~TaskScheduler();
+
+    // Submit a task to a Taskable, starting its chain on the pool if it needs an external start
+    inline void submit(Taskable *target, Task *task) {
+        if (!target->scheduleExecution(task))
+            start(target, task);
+    }
+    // Start a task needing an external start on the pool
+    void start(Taskable *target, Task *task);
+    // Replacement of target->endTask(task) bounding the recursion depth of synchronous completions
+    // Without a TaskScheduler instance, this is target->endTask(task)
+    static void endTask(Taskable *target, Task *task);
+    // Stop worker threads, once every started task has been started
+    void stop();
+
+    static TaskScheduler *instance;
+private:
+    struct StartRequest {
+        Taskable *target;
+        Task *task;
+    };
+    void workerloop();
+    const unsigned int maxBurst;
+    std::vector<std::thread> workers;
+    std::deque<StartRequest> requests;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool alive = true;
+    static thread_local unsigned int depth; // Nested synchronous completions on this thread
+};
@@ -3,6 +3,19 @@
 
 //#define TASKABLE_REFERENCE_COUNT
 //#define TASKABLE_TASK_KEEP_REFERENCE
+//#define TASKABLE_TRAMPOLINE
+
+#ifdef TASKABLE_TRAMPOLINE
+#include <vector>
+#include <utility>
+
+// Successors to start by the outermost endTask of a thread
+struct TaskableTrampoline {
+    std::vector<std::pair<class Taskable *, Task *>> pending;
+    size_t readIdx = 0;
+    bool active = false;
+};
+#endif
 
 // A Taskable is an "effective thread": it serializes the Tasks submitted to it, so the
 // state it protects is accessed sequentially-consistently regardless of which physical
@@ -21,7 +34,7 @@
 //   or the chain empties - the successor's producer may write task->next AFTER
 //   endTask(task) returned (marker window). Inert after endTask is NOT reclaimable.
 //   Guarantee lifetime externally (e.g. Task embedded in a refcounted resource object)
-//   or via a dedicated flag (not yet implemented).
+//   or poll task->reclaimable(), set once both sides are done with it (see TaskPool).
 // - scheduleExecution(task) == false means the task needs an external start: either the
 //   chain was idle, or the finishing consumer passed the marker window. Both mean the
 //   same thing: this Taskable must be registered wherever external starts happen
@@ -29,6 +42,8 @@
 // - Synchronous completion nests: endTask called inside start() cascades on the stack,
 //   so an uninterrupted chain of depth N recurses N deep (unless tail-call optimized).
 //   Chains going idle resets this - prefer bounded bursts over never-idle chains.
+//   With TASKABLE_TRAMPOLINE, a nested endTask instead hands the successor to the outermost
+//   endTask of this thread, which starts successors in FIFO order: the depth no longer grows.
 class Taskable {
 public:
     #ifdef TASKABLE_REFERENCE_COUNT
@@ -43,8 +58,10 @@ public:
     #endif
     inline void execute(Task *task) {
         if (Task *last = lastTask.exchange(task, std::memory_order_acquire)) {
-            if (last->next.exchange(task, std::memory_order_acq_rel))
+            if (last->next.exchange(task, std::memory_order_acq_rel)) {
+                last->reclaimFlag.store(true, std::memory_order_release); // Past the marker window
                 task->start(this);
+            }
         } else {
             #ifdef TASKABLE_TASK_KEEP_REFERENCE
             refCount.fetch_add(1, std::memory_order_relaxed);
@@ -54,22 +71,56 @@ public:
     }
     inline bool scheduleExecution(Task *task) {
         if (Task *last = lastTask.exchange(task, std::memory_order_acquire)) {
-            return (last->next.exchange(task, std::memory_order_acq_rel) == nullptr);
+            if (last->next.exchange(task, std::memory_order_acq_rel) == nullptr)
+                return true;
+            last->reclaimFlag.store(true, std::memory_order_release); // Past the marker window
         }
         return false;
     }
     inline void endTask(Task *task) {
-        if (lastTask.compare_exchange_strong(task, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+        #ifdef TASKABLE_TRAMPOLINE
+        if (Task *next = completeTask(task)) {
+            TaskableTrampoline &t = trampoline;
+            if (t.active) {
+                t.pending.emplace_back(this, next);
+                return;
+            }
+            t.active = true;
+            next->start(this);
+            while (t.readIdx < t.pending.size()) {
+                auto p = t.pending[t.readIdx++];
+                p.second->start(p.first);
+            }
+            t.pending.clear();
+            t.readIdx = 0;
+            t.active = false;
+        }
+        #else
+        if (Task *next = completeTask(task))
+            next->start(this);
+        #endif
+    }
+    // Like endTask, but return the successor instead of starting it, or nullptr if there is none
+    // The caller is responsible for starting the returned task exactly once
+    inline Task *completeTask(Task *task) {
+        Task *expected = task; // Overwritten on failure, task must be preserved
+        if (lastTask.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+            task->reclaimFlag.store(true, std::memory_order_release);
             #ifdef TASKABLE_TASK_KEEP_REFERENCE
             release();
             #endif
-        } else {
-            if (Task *next = task->next.exchange(task, std::memory_order_acq_rel)) {
-                next->start(this);
-            }
+            return nullptr;
         }
+        Task *next = task->next.exchange(task, std::memory_order_acq_rel);
+        // Otherwise, the producer of the successor reclaim it once past the marker window
+        if (next)
+            task->reclaimFlag.store(true, std::memory_order_release);
+        return next;
     }
 private:
+    #ifdef TASKABLE_TRAMPOLINE
+    static inline thread_local TaskableTrampoline trampoline;
+    #endif
     std::atomic<Task*> lastTask = nullptr;
     #ifdef TASKABLE_REFERENCE_COUNT
     std::atomic<int> refCount = 0;
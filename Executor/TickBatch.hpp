@@ -0,0 +1,29 @@
+#ifndef TICK_BATCH_HPP_
+#define TICK_BATCH_HPP_
+
+#include <cstdint>
+
+//! Storage of ticking objects of a single type, advanced together by the tick
+//! manager with one call per tick instead of one virtual call per object.
+//! Implementations keep the per-object state in contiguous arrays (SoA) so the
+//! common part of the update can be vectorized.
+class TickBatch {
+public:
+    virtual ~TickBatch() = default;
+    //! Advance every element, removing the ones which have completed
+    void update(float deltaTime) {
+        advance(deltaTime, 0, size());
+        collect();
+    }
+    //! Number of elements, advanced ranges are within [0, size())
+    virtual uint32_t size() const = 0;
+    //! Advance the elements of [begin, end) and flag the completed ones
+    //! Disjoint ranges may be advanced concurrently
+    virtual void advance(float deltaTime, uint32_t begin, uint32_t end) = 0;
+    //! Remove the elements flagged by advance
+    virtual void collect() = 0;
+    //! Sever every element from the manager, called on manager destruction
+    virtual void detach() = 0;
+};
+
+#endif /* end of include guard: TICK_BATCH_HPP_ */
@@ -2,7 +2,18 @@
 #define TICK_MGR_HPP_
 
 #include "Tickable.hpp"
-#include <list>
+#include "TickBatch.hpp"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Number of tickables or batch elements processed at once by a thread in parallel mode
+#define TICK_MGR_CHUNK_SIZE 2048
+
 //! Simple synchronous ticking engine. CRTP: a concrete manager gains the
 //! registry, the tick and the teardown by deriving TickMgr<Self> - its
 //! tickables are then Tickable<Self> and register through Self::instance.
@@ -10,26 +21,179 @@ template <class Derived>
 class TickMgr {
 public:
     void update(float deltaTime) {
-        updateList.remove_if([deltaTime](auto *obj){return obj->update(deltaTime);});
+        if (!workers.empty()) {
+            parallelUpdate(deltaTime);
+            return;
+        }
+        for (auto &batch : batches) {
+            if (batch)
+                batch->update(deltaTime);
+        }
+        // Backward, so that a swap-remove only move an already updated tickable
+        // An update may start or stop ticking any tickable, including itself, see stopTicking
+        updating = true;
+        for (uint32_t i = updateList.size(); i--;) {
+            updateIndex = i;
+            Tickable<Derived> *tickable = updateList[i];
+            if (!tickable || tickable->update(deltaTime) || !updateList[i])
+                erase(i);
+        }
+        updating = false;
+    }
+
+    //! Update with threadCount threads in addition to the calling one, or single-threaded if 0
+    //! In parallel mode, the update of a tickable must not affect any other tickable,
+    //! nor start or stop ticking. Completed tickables are removed once every update
+    //! has returned, leaving the same order as a single-threaded update.
+    void setThreadCount(unsigned int threadCount) {
+        if (!workers.empty()) {
+            mtx.lock();
+            alive = false;
+            mtx.unlock();
+            cv.notify_all();
+            for (auto &t : workers)
+                t.join();
+            workers.clear();
+            alive = true;
+        }
+        while (threadCount--)
+            workers.push_back(std::thread(&TickMgr::workerloop, this, generation));
     }
 
     inline void startTicking(Tickable<Derived> *arg) {
+        arg->tickIndex = updateList.size();
         updateList.push_back(arg);
     }
 
+    //! While updating, a tickable which isn't updated yet (or is being updated) is only
+    //! cleared, and removed once the update reaches it. Removing it at once would move
+    //! an already updated tickable in its place, which would then be updated twice.
     inline void stopTicking(Tickable<Derived> *arg) {
-        updateList.remove(arg);
+        if (updating && arg->tickIndex <= updateIndex)
+            updateList[arg->tickIndex] = nullptr;
+        else
+            erase(arg->tickIndex);
+    }
+
+    //! Return the batch storage of this type, created on first use
+    template <class Batch>
+    Batch &getBatch() {
+        static const size_t id = batchTypeCount++;
+        if (id >= batches.size())
+            batches.resize(id + 1);
+        if (!batches[id])
+            batches[id] = std::make_unique<Batch>();
+        return static_cast<Batch &>(*batches[id]);
     }
 
     //! On manager destruction, sever every still-registered Tickable so one
     //! that outlives its manager (e.g. quitting while a transition is active)
     //! will not call stopTicking() on freed manager memory from ~Tickable.
     ~TickMgr() {
+        setThreadCount(0);
         for (auto *t : updateList)
             t->detach();
+        for (auto &batch : batches) {
+            if (batch)
+                batch->detach();
+        }
     }
 private:
-    std::list<Tickable<Derived> *> updateList;
+    struct Chunk {
+        TickBatch *batch; // nullptr for a range of updateList
+        uint32_t begin;
+        uint32_t end;
+    };
+
+    inline void erase(uint32_t idx) {
+        updateList[idx] = updateList.back();
+        updateList.pop_back();
+        if (idx < updateList.size())
+            updateList[idx]->tickIndex = idx;
+    }
+
+    void parallelUpdate(float deltaTime) {
+        chunks.clear();
+        for (auto &batch : batches) {
+            if (!batch)
+                continue;
+            const uint32_t size = batch->size();
+            for (uint32_t i = 0; i < size; i += TICK_MGR_CHUNK_SIZE)
+                chunks.push_back({batch.get(), i, std::min<uint32_t>(i + TICK_MGR_CHUNK_SIZE, size)});
+        }
+        const uint32_t size = updateList.size();
+        for (uint32_t i = 0; i < size; i += TICK_MGR_CHUNK_SIZE)
+            chunks.push_back({nullptr, i, std::min<uint32_t>(i + TICK_MGR_CHUNK_SIZE, size)});
+        finished.resize(size);
+        chunkDeltaTime = deltaTime;
+        nextChunk.store(0, std::memory_order_relaxed);
+        if (chunks.size() > 1) {
+            mtx.lock();
+            ++generation;
+            pendingWorkers = workers.size();
+            mtx.unlock();
+            cv.notify_all();
+            processChunks();
+            std::unique_lock<std::mutex> lock(mtx);
+            doneCv.wait(lock, [this]{return pendingWorkers == 0;});
+        } else
+            processChunks();
+        // Removal phase, single-threaded and in a fixed order
+        for (auto &batch : batches) {
+            if (batch)
+                batch->collect();
+        }
+        for (uint32_t i = size; i--;) {
+            if (finished[i])
+                erase(i);
+        }
+    }
+
+    void processChunks() {
+        uint32_t idx;
+        while ((idx = nextChunk.fetch_add(1, std::memory_order_relaxed)) < chunks.size()) {
+            const Chunk &chunk = chunks[idx];
+            if (chunk.batch) {
+                chunk.batch->advance(chunkDeltaTime, chunk.begin, chunk.end);
+            } else {
+                for (uint32_t i = chunk.begin; i < chunk.end; ++i)
+                    finished[i] = updateList[i]->update(chunkDeltaTime);
+            }
+        }
+    }
+
+    void workerloop(uint32_t lastGeneration) {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (alive) {
+            if (generation != lastGeneration) {
+                lastGeneration = generation;
+                lock.unlock();
+                processChunks();
+                lock.lock();
+                if (--pendingWorkers == 0)
+                    doneCv.notify_one();
+            } else
+                cv.wait(lock);
+        }
+    }
+
+    std::vector<Tickable<Derived> *> updateList; // nullptr for a tickable stopped during update, until the update reaches it
+    uint32_t updateIndex; // Index of the tickable being updated
+    bool updating = false; // Single-threaded update in progress
+    std::vector<std::unique_ptr<TickBatch>> batches; // Indexed by batch type
+    static inline size_t batchTypeCount = 0;
+    // Parallel mode
+    std::vector<std::thread> workers;
+    std::vector<Chunk> chunks;
+    std::vector<uint8_t> finished; // Update result of each tickable of updateList
+    std::atomic<uint32_t> nextChunk;
+    float chunkDeltaTime;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::condition_variable doneCv;
+    uint32_t generation = 0;
+    unsigned int pendingWorkers = 0;
+    bool alive = true;
 };
 
 #endif /* end of include guard: TICK_MGR_HPP_ */
@@ -1,8 +1,14 @@
 #ifndef TICKABLE_HPP_
 #define TICKABLE_HPP_
 
-template <class TickMgr>
+#include <cstdint>
+
+template <class Derived>
+class TickMgr;
+
+template <class Mgr>
 class Tickable {
+    friend class TickMgr<Mgr>;
 public:
     Tickable() = default;
     virtual ~Tickable() {
@@ -14,20 +20,22 @@ public:
     //! Sever the manager back-reference. The tick manager calls this from its
     //! own destructor when it is going away, so a Tickable that outlives its
     //! manager (e.g. quitting while a transition is still active) will not call
-    //! stopTicking() on freed manager memory from ~Tickable. `mgr` stays private
-    //! to Tickable: the manager drives this state transition through this method,
-    //! it never reaches into Tickable's internals.
+    //! stopTicking() on freed manager memory from ~Tickable. The manager clears
+    //! `mgr` through this method; the only internal it touches directly (as a
+    //! friend) is `tickIndex`, its own bookkeeping for O(1) removal.
     void detach() noexcept { mgr = nullptr; }
 protected:
     //! Inform about a new ticking dependency
-    inline void needUpdate(TickMgr *_mgr) {
+    inline void needUpdate(Mgr *_mgr) {
         if (!mgr) {
             mgr = _mgr;
             _mgr->startTicking(this);
         }
     }
     //! This member MUST be set to nullptr before returning true in update()
-    TickMgr *mgr = nullptr;
+    Mgr *mgr = nullptr;
+private:
+    uint32_t tickIndex; // Position in the update list of the manager while ticking
 };
 
 #endif /* end of include guard: TICKABLE_HPP_ */
@@ -1,53 +1,192 @@
 #include "gc.hpp"
 #include <thread>
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
 
 unsigned int gc::preservationCycles = 2;
 unsigned int gc::cycle = 256;
 unsigned int gc::collectedCycle = 255;
 std::chrono::milliseconds gc::collectionDeltaTime(500);
 std::chrono::milliseconds gc::loadingDeltaTime(50);
+size_t gc::memoryBudget = 0;
+bool (*gc::isMemoryLow)() = nullptr;
 
 static bool active = false;
 static std::thread thread;
-static GCObject *loadingObj[256]; // Objects to load
-static GCObject *loadedObj[65536]; // Objects loaded
-static unsigned char readIdx = 0;
-static unsigned char writeIdx = 0;
+static std::atomic<GCObject *> loadingObj{nullptr}; // Objects to load, linked through GCObject::nextLoad, last inserted first
+static std::atomic<GCObject *> completedObj{nullptr}; // Objects which have completed loading, linked the same way
+static std::vector<GCObject *> loadedObj; // Objects loaded
+static size_t residentCost = 0; // Sum of the cost of loaded objects
+
+// Worker pool
+static std::vector<std::thread> workers;
+static std::deque<GCObject *> loadJobs; // Served in submission order
+static std::deque<GCObject *> unloadJobs; // Served before loadJobs, least recently used first on eviction
+static std::mutex jobMtx;
+static std::condition_variable jobCv;
+static bool workersAlive = false; // Protected by jobMtx
+
+// Statistics
+static std::atomic<unsigned int> loadCount{0};
+static std::atomic<uint64_t> loadTime{0};
+static std::atomic<uint64_t> unloadTime{0};
+static gc::CycleStats lastCycleStats;
+static std::mutex statsMtx;
+
+static void push(std::atomic<GCObject *> &list, GCObject *obj) {
+    GCObject *head = list.load(std::memory_order_relaxed);
+    do {
+        obj->nextLoad = head;
+    } while (!list.compare_exchange_weak(head, obj, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// Extract every object of the list, in insertion order
+static GCObject *popAll(std::atomic<GCObject *> &list) {
+    GCObject *obj = list.exchange(nullptr, std::memory_order_acquire);
+    GCObject *ordered = nullptr;
+    while (obj) {
+        GCObject *next = obj->nextLoad;
+        obj->nextLoad = ordered;
+        ordered = obj;
+        obj = next;
+    }
+    return ordered;
+}
+
+static void loadObject(GCObject *obj) {
+    auto begin = std::chrono::steady_clock::now();
+    obj->load();
+    obj->residentCost = obj->getResidentCost();
+    obj->loaded = true;
+    loadTime.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count(), std::memory_order_relaxed);
+    loadCount.fetch_add(1, std::memory_order_relaxed);
+    push(completedObj, obj); // Inserted in loadedObj by the gc thread
+}
+
+// Give this unloaded object back to its owner, or delete it if it has been destroyed meanwhile
+static void release(GCObject *obj) {
+    if (obj->deletable.exchange(true))
+        delete obj;
+}
+
+static void unloadObject(GCObject *obj) {
+    auto begin = std::chrono::steady_clock::now();
+    obj->unload();
+    unloadTime.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count(), std::memory_order_relaxed);
+    release(obj);
+}
+
+static void workerloop() {
+    std::unique_lock<std::mutex> lock(jobMtx);
+    while (true) {
+        if (!unloadJobs.empty()) {
+            GCObject *obj = unloadJobs.front();
+            unloadJobs.pop_front();
+            lock.unlock();
+            unloadObject(obj);
+            lock.lock();
+        } else if (!loadJobs.empty()) {
+            GCObject *obj = loadJobs.front();
+            loadJobs.pop_front();
+            lock.unlock();
+            loadObject(obj);
+            lock.lock();
+        } else if (workersAlive) {
+            jobCv.wait(lock);
+        } else
+            return;
+    }
+}
 
 static void mainloop() {
     auto nextCycle = std::chrono::steady_clock::now() + gc::loadingDeltaTime;
     auto nextCollection = nextCycle + gc::collectionDeltaTime;
-    unsigned short loadedCount = 0;
     while (active) {
-        // Process loading cycle
-        while (readIdx != writeIdx) {
-            GCObject *obj = loadingObj[readIdx++];
-            obj->load();
-            obj->loaded = true;
-            loadedObj[loadedCount++] = obj;
+        // Process loading cycle, slow loads performed by workers don't delay the gc thread
+        GCObject *pending = popAll(loadingObj);
+        if (workers.empty()) {
+            while (pending) {
+                GCObject *next = pending->nextLoad;
+                loadObject(pending);
+                pending = next;
+            }
+        } else if (pending) {
+            std::lock_guard<std::mutex> lock(jobMtx);
+            for (; pending; pending = pending->nextLoad)
+                loadJobs.push_back(pending);
+            jobCv.notify_all();
+        }
+        for (GCObject *obj = popAll(completedObj); obj; obj = obj->nextLoad) {
+            residentCost += obj->residentCost;
+            loadedObj.push_back(obj);
         }
         // Process collection cycle
         if (nextCycle > nextCollection) {
+            // Every object whose last use is older than this generation is unloaded
             const unsigned int unloadCycle = ++gc::cycle - gc::preservationCycles;
             gc::collectedCycle = unloadCycle;
-            GCObject **src = loadedObj;
-            GCObject **dst = src;
-            unsigned short i = loadedCount;
-            while (i--) {
-                if ((**src).lastUse <= unloadCycle) {
-                    (**src).loaded = false;
-                    (**src).unload();
-                    if ((**src).deletable) {
-                        delete *src;
-                    } else {
-                        (**src).deletable = true;
-                    }
+            auto dst = loadedObj.begin();
+            unsigned int unloaded = 0;
+            unsigned int evicted = 0;
+            std::unique_lock<std::mutex> lock(jobMtx, std::defer_lock);
+            if (!workers.empty())
+                lock.lock();
+            auto unload = [&unloaded](GCObject *obj) {
+                obj->loaded = false;
+                residentCost -= obj->residentCost;
+                if (workers.empty())
+                    unloadObject(obj);
+                else
+                    unloadJobs.push_back(obj);
+                ++unloaded;
+            };
+            for (GCObject *obj : loadedObj) {
+                if (obj->lastUse <= unloadCycle) {
+                    unload(obj);
                 } else {
-                    *(dst++) = *src;
+                    *(dst++) = obj;
+                }
+            }
+            loadedObj.erase(dst, loadedObj.end());
+            // Process memory pressure, unloading least recently used objects first
+            const bool lowMemory = gc::isMemoryLow && gc::isMemoryLow();
+            if (lowMemory || (gc::memoryBudget && residentCost > gc::memoryBudget)) {
+                std::stable_sort(loadedObj.begin(), loadedObj.end(), [](GCObject *a, GCObject *b){
+                    return a->lastUse < b->lastUse;
+                });
+                auto it = loadedObj.begin();
+                // Objects used since the previous collection cycle are only unloaded to fit in the budget
+                // They are loaded again on their next use, see GCObject::used
+                if (lowMemory) {
+                    while (it != loadedObj.end() && (*it)->lastUse < gc::cycle - 1)
+                        unload(*(it++));
                 }
-                ++src;
+                if (gc::memoryBudget) {
+                    while (it != loadedObj.end() && residentCost > gc::memoryBudget)
+                        unload(*(it++));
+                }
+                evicted = it - loadedObj.begin();
+                loadedObj.erase(loadedObj.begin(), it);
+            }
+            if (lock.owns_lock()) {
+                // Don't wait for unloads, an object isn't loaded again until its unload completes (see GCObject::deletable)
+                jobCv.notify_all();
+                lock.unlock();
+            }
+            {
+                std::lock_guard<std::mutex> lock(statsMtx);
+                lastCycleStats.loaded = loadCount.exchange(0, std::memory_order_relaxed);
+                lastCycleStats.unloaded = unloaded;
+                lastCycleStats.resident = loadedObj.size();
+                lastCycleStats.evicted = evicted;
+                lastCycleStats.residentCost = residentCost;
+                lastCycleStats.loadTime = std::chrono::microseconds(loadTime.exchange(0, std::memory_order_relaxed));
+                lastCycleStats.unloadTime = std::chrono::microseconds(unloadTime.exchange(0, std::memory_order_relaxed));
             }
-            loadedCount = dst - loadedObj;
             nextCollection = nextCycle + gc::collectionDeltaTime; // Avoid cycle spaced by less than collectionDeltaTime
         }
         // Wait for next cycle
@@ -59,30 +198,41 @@ static void mainloop() {
             nextCycle = now + gc::loadingDeltaTime; // Avoid cycle spaced by less than loadingDeltaTime
         }
     }
-    // Final collection cycle - unload everything
-    while (readIdx != writeIdx) {
-        GCObject *obj = loadingObj[readIdx++];
-        if (obj->deletable) {
-            delete obj;
-        } else {
-            obj->deletable = true;
+    // Complete pending loads
+    if (!workers.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(jobMtx);
+            workersAlive = false;
+            jobCv.notify_all();
         }
+        for (auto &t : workers)
+            t.join();
+        workers.clear();
     }
-    for (GCObject **src = loadedObj; loadedCount--; ++src) {
-        (**src).unload();
-        if ((**src).deletable) {
-            delete *src;
-        } else {
-            (**src).deletable = true;
-        }
+    for (GCObject *obj = popAll(completedObj); obj; obj = obj->nextLoad)
+        loadedObj.push_back(obj);
+    residentCost = 0;
+    // Final collection cycle - unload everything
+    for (GCObject *obj = popAll(loadingObj); obj;) {
+        GCObject *next = obj->nextLoad;
+        release(obj);
+        obj = next;
     }
+    for (GCObject *obj : loadedObj) {
+        obj->unload();
+        release(obj);
+    }
+    loadedObj.clear();
 }
 
-void gc::start() {
+void gc::start(unsigned int workerCount) {
     if (!active) {
         active = true;
         if (thread.joinable())
             thread.join();
+        workersAlive = true;
+        while (workerCount--)
+            workers.push_back(std::thread(workerloop));
         thread = std::thread(mainloop);
     }
 }
@@ -98,7 +248,11 @@ void gc::waitStopped() {
 }
 
 void gc::load(GCObject *obj) {
-    static unsigned char writingIdx = 255;
-    loadingObj[++writingIdx] = obj;
-    ++writeIdx;
+    // Lock-free insertion, any thread may load an object
+    push(loadingObj, obj);
+}
+
+gc::CycleStats gc::getLastCycleStats() {
+    std::lock_guard<std::mutex> lock(statsMtx);
+    return lastCycleStats;
 }
@@ -2,20 +2,40 @@
 #define GC_HPP_
 
 #include <chrono>
+#include <cstddef>
+#include <atomic>
 
 class GCObject;
 
 // Garbage Collector manager
 namespace gc {
-    void start();
+    struct CycleStats {
+        unsigned int loaded = 0; // Objects loaded since the previous collection cycle
+        unsigned int unloaded = 0; // Objects unloaded by the collection cycle
+        unsigned int resident = 0; // Objects loaded after the collection cycle
+        unsigned int evicted = 0; // Objects unloaded by the collection cycle to fit in the memory budget
+        size_t residentCost = 0; // Sum of the cost of objects loaded after the collection cycle
+        std::chrono::microseconds loadTime{0}; // Time spent in GCObject::load, summed over threads
+        std::chrono::microseconds unloadTime{0}; // Time spent in GCObject::unload, summed over threads
+    };
+    // Start the gc thread, with workerCount threads performing load() and unload()
+    // With no worker, load() and unload() are performed by the gc thread
+    void start(unsigned int workerCount = 0);
     void stop();
     void waitStopped();
     void load(GCObject *obj);
+    // Return statistics of the last collection cycle, useful to tune preservationCycles
+    CycleStats getLastCycleStats();
     extern unsigned int cycle;
     extern unsigned int collectedCycle;
     extern unsigned int preservationCycles; // Number of collection cycles before unloading
     extern std::chrono::milliseconds collectionDeltaTime; // Time between unloading cycles
     extern std::chrono::milliseconds loadingDeltaTime; // Time between loading cycles
+    // Maximal sum of GCObject::getResidentCost, least recently used objects are unloaded above it, 0 for no limit
+    extern size_t memoryBudget;
+    // Optional, called on each collection cycle, return true if the memory is low (e.g. from MemoryManager::querryMemory)
+    // When it does, every object unused since the previous collection cycle is unloaded, least recently used first
+    extern bool (*isMemoryLow)();
 };
 
 // Garbage Collectable object, call load() and unload()
@@ -24,10 +44,14 @@ public:
     virtual ~GCObject() = default;
     virtual void load() = 0;
     virtual void unload() = 0;
+    // Memory used by this object while loaded, queried after load()
+    virtual size_t getResidentCost() const {return 0;}
     bool used() { // Load or keep this object loaded, return true if this object is currently loaded
         if (lastUse > gc::collectedCycle) {
             lastUse = gc::cycle;
-            return loaded;
+            if (loaded)
+                return true;
+            // Evicted while in use, lastUse is recent but this object must be loaded again
         }
         if (deletable) {
             lastUse = gc::cycle;
@@ -41,17 +65,20 @@ public:
         lastUse = 0;
     }
     void destroy() { // Delete this object
-        if (deletable) {
+        if (deletable.exchange(true)) {
             delete this;
         } else {
-            deletable = true;
             lastUse = 0;
         }
     }
     // Internal state - accessed in gc.cpp
     unsigned int lastUse = 0;
-    bool loaded = false; // Indicate if this object is currently loaded
-    bool deletable = true; // MAYBE switch to atomic_flag
+    std::atomic<bool> loaded{false}; // Indicate if this object is currently loaded
+    // Not owned by the gc, or destroyed while owned by the gc
+    // Neither loaded nor deletable means queued for loading or unloading, it is not loaded again before that
+    std::atomic<bool> deletable{true};
+    GCObject *nextLoad = nullptr; // Next object of the loading queue
+    size_t residentCost = 0; // Cost accounted while loaded
 };
 
 // For class deriving from GCObject
@@ -0,0 +1,95 @@
+/*
+** EntityCore
+** Test - MPMCQueue
+** File description:
+** Stress test of MPMCQueue with several producers and consumers, checking every element is received exactly once and intact
+** Build : g++ -std=c++20 -O2 MPMCQueueTest.cpp -o MPMCQueueTest -lpthread
+** Usage : ./MPMCQueueTest [producers] [consumers] [elements per producer]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Tools/SafeQueue.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+
+// Non-scalar element, so a partially-moved element would be detected
+struct Item {
+    uint32_t id;
+    std::string payload;
+};
+
+static std::string makePayload(uint32_t id)
+{
+    return "payload-" + std::to_string(id) + std::string(id % 37, '#');
+}
+
+template <unsigned int capacity>
+static bool stress(int producerCount, int consumerCount, uint32_t perProducer)
+{
+    auto queue = std::make_unique<MPMCQueue<Item, capacity>>();
+    const uint32_t total = producerCount * perProducer;
+    std::unique_ptr<std::atomic<uint8_t>[]> received(new std::atomic<uint8_t>[total]);
+    for (uint32_t i = 0; i < total; ++i)
+        received[i].store(0, std::memory_order_relaxed);
+    std::atomic<uint32_t> popped{0};
+    std::atomic<uint32_t> corrupted{0};
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producerCount; ++p) {
+        threads.emplace_back([&, p]{
+            for (uint32_t i = 0; i < perProducer; ++i) {
+                Item item {p * perProducer + i, makePayload(p * perProducer + i)};
+                while (!queue->push(item))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < consumerCount; ++c) {
+        threads.emplace_back([&]{
+            Item item;
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (!queue->pop(item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                popped.fetch_add(1, std::memory_order_relaxed);
+                if (item.id >= total || item.payload != makePayload(item.id))
+                    corrupted.fetch_add(1, std::memory_order_relaxed);
+                else
+                    received[item.id].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+
+    uint32_t missing = 0;
+    uint32_t duplicated = 0;
+    for (uint32_t i = 0; i < total; ++i) {
+        missing += (received[i] == 0);
+        duplicated += (received[i] > 1);
+    }
+    const bool success = !missing && !duplicated && !corrupted && queue->empty();
+    std::cout << (success ? "OK   " : "FAIL ") << "capacity " << capacity << ", " << producerCount << " producers, " << consumerCount << " consumers, " << total << " elements";
+    if (!success)
+        std::cout << " : " << missing << " missing, " << duplicated << " duplicated, " << corrupted << " corrupted";
+    std::cout << '\n';
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    const int producerCount = (argc > 1) ? std::atoi(argv[1]) : 4;
+    const int consumerCount = (argc > 2) ? std::atoi(argv[2]) : 4;
+    const uint32_t perProducer = (argc > 3) ? std::atoi(argv[3]) : 200000;
+    bool success = true;
+    // Small capacity to stress the full and empty cases, large one to check capacities above 65535
+    success &= stress<2>(producerCount, consumerCount, perProducer / 10);
+    success &= stress<64>(producerCount, consumerCount, perProducer);
+    success &= stress<(1U << 17)>(producerCount, consumerCount, perProducer);
+    success &= stress<256>(1, 1, perProducer);
+    return success ? 0 : 1;
+}
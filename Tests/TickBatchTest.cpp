@@ -0,0 +1,291 @@
+/*
+** EntityCore
+** Test - TickBatch
+** File description:
+** Random transitions of AFader and ASmooth advanced by their batch, checked against a scalar model, and single-threaded against parallel updates
+** Build : g++ -std=c++20 -O2 TickBatchTest.cpp -o TickBatchTest -lpthread
+** Usage : ./TickBatchTest [elements] [ticks]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Executor/TickMgr.hpp"
+#include "../Executor/AFader.hpp"
+#include "../Executor/ASmooth.hpp"
+#include <iostream>
+#include <random>
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+
+class SingleMgr : public TickMgr<SingleMgr> {
+public:
+    static inline SingleMgr *instance = nullptr;
+};
+
+class ParallelMgr : public TickMgr<ParallelMgr> {
+public:
+    static inline ParallelMgr *instance = nullptr;
+};
+
+struct SquareInterp {
+    float operator()(float t) const {return t * t;}
+    float one() const {return 1;}
+    float zero() const {return 0;}
+};
+
+// Scalar model of a fader, as AFader::update with the timer clamped within [0, duration]
+// so that shortening the duration of a fading out fader never overshoots
+struct RefFader {
+    float value;
+    float timer;
+    float duration;
+    bool state;
+    bool transiting = false;
+    void update(float deltaTime) {
+        if (!transiting)
+            return;
+        if (state) {
+            if ((timer += deltaTime) >= duration) {
+                timer = duration;
+                value = 1;
+                transiting = false;
+                return;
+            }
+        } else {
+            if ((timer -= deltaTime) <= 0) {
+                timer = 0;
+                value = 0;
+                transiting = false;
+                return;
+            }
+            if (timer > duration)
+                timer = duration;
+        }
+        value = SquareInterp()(timer / duration);
+    }
+};
+
+// Scalar model of a smooth, as ASmooth::set and ASmooth::update
+struct RefSmooth {
+    float a = 0, b = 0, c = 0;
+    float timer = 0, duration = 0, nextDuration = 0;
+    bool moving = false;
+    bool fromRest = true; // The current movement started from rest, so it lands exactly on its target
+    void set(float dst, float minDuration) {
+        if (moving) {
+            fromRest = false;
+            if (minDuration < duration + nextDuration)
+                minDuration = duration + nextDuration;
+            c += timer * (b + timer * a);
+            dst -= c;
+            b += timer * a*2;
+            if (b == 0) {
+                timer = 0;
+                duration = nextDuration = minDuration / 2;
+                a = (dst/2) / (duration*duration);
+                return;
+            }
+            const float tmp = std::sqrt(dst*dst + b*minDuration*(b * minDuration / 2 - dst));
+            float accelerationTime = (dst - tmp)/b;
+            if (accelerationTime < 0 || accelerationTime > minDuration)
+                accelerationTime = (dst + tmp)/b;
+            a = -b / (accelerationTime * 4 - minDuration * 2);
+            timer = 0;
+            duration = accelerationTime;
+            nextDuration = minDuration - duration;
+        } else {
+            fromRest = true;
+            duration = nextDuration = minDuration / 2;
+            dst -= c;
+            a = (dst/2) / (duration*duration);
+            b = 0;
+            timer = 0;
+            moving = true;
+        }
+    }
+    void update(float deltaTime) {
+        if (moving && (timer += deltaTime) >= duration) {
+            c += duration * (b + duration * a);
+            if (nextDuration) {
+                b += duration * a*2;
+                a = -a;
+                deltaTime = timer - duration;
+                duration = nextDuration;
+                nextDuration = 0;
+                timer = 0;
+                update(deltaTime);
+            } else
+                moving = false;
+        }
+    }
+    float value() const {
+        return moving ? ((a * timer) + b) * timer + c : c;
+    }
+};
+
+template <class Mgr>
+using Fader = AFader<Mgr, SquareInterp>;
+
+template <class Mgr>
+using Smooth = ASmooth<Mgr, float>;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what, uint32_t tick, uint32_t idx)
+{
+    if (!ok && failures++ < 10)
+        std::cerr << what << " mismatch at tick " << tick << ", element " << idx << std::endl;
+}
+
+// Every operation is applied to both managers, which must give identical results
+static void testFaders(uint32_t count, uint32_t ticks)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> unit(0, 1);
+    std::vector<RefFader> ref(count);
+    std::vector<std::unique_ptr<Fader<SingleMgr>>> single;
+    std::vector<std::unique_ptr<Fader<ParallelMgr>>> parallel;
+    for (uint32_t i = 0; i < count; ++i) {
+        const float duration = 0.1f + unit(rng);
+        single.push_back(std::make_unique<Fader<SingleMgr>>(false, duration));
+        parallel.push_back(std::make_unique<Fader<ParallelMgr>>(false, duration));
+        ref[i] = {0, 0, duration, false};
+    }
+    for (uint32_t tick = 0; tick < ticks; ++tick) {
+        for (uint32_t n = count / 16; n--;) {
+            const uint32_t i = rng() % count;
+            switch (rng() % 4) {
+                case 0: // Change of direction
+                case 1:
+                    *single[i] = !single[i]->finalState();
+                    *parallel[i] = !parallel[i]->finalState();
+                    ref[i].state = !ref[i].state;
+                    ref[i].transiting = true;
+                    break;
+                case 2: { // Change of duration
+                    const float duration = 0.1f + unit(rng);
+                    single[i]->setDuration(duration);
+                    parallel[i]->setDuration(duration);
+                    ref[i].duration = duration;
+                    if (!ref[i].transiting && ref[i].state)
+                        ref[i].timer = duration;
+                    break;
+                }
+                case 3: { // Copy of another fader, possibly transiting
+                    const uint32_t j = rng() % count;
+                    *single[i] = *single[j];
+                    *parallel[i] = *parallel[j];
+                    ref[i] = ref[j];
+                    break;
+                }
+            }
+        }
+        const float deltaTime = unit(rng) * 0.05f;
+        SingleMgr::instance->update(deltaTime);
+        ParallelMgr::instance->update(deltaTime);
+        for (uint32_t i = 0; i < count; ++i) {
+            ref[i].update(deltaTime);
+            check(std::abs(single[i]->getInterstate() - ref[i].value) < 1e-4f, "AFader value", tick, i);
+            check(single[i]->isTransiting() == ref[i].transiting, "AFader transiting", tick, i);
+            check(single[i]->getInterstate() == parallel[i]->getInterstate(), "AFader parallel value", tick, i);
+        }
+    }
+    // Destruction of transiting faders must leave the batch consistent
+    for (uint32_t i = 0; i < count; i += 2) {
+        single[i].reset();
+        parallel[i].reset();
+    }
+    for (uint32_t tick = 0; tick < 100; ++tick) {
+        SingleMgr::instance->update(0.05f);
+        ParallelMgr::instance->update(0.05f);
+    }
+    for (uint32_t i = 1; i < count; i += 2) {
+        check(!single[i]->isTransiting() && !parallel[i]->isTransiting(), "AFader completion", ticks, i);
+        check(single[i]->getInterstate() == (single[i]->finalState() ? 1.f : 0.f), "AFader final value", ticks, i);
+    }
+}
+
+// The model reproduces the singularities of ASmooth::set (e.g. a retarget at the very end of a movement
+// with a rounded non-zero velocity), so non-finite values must match too
+static bool near(float value, float expected)
+{
+    if (!std::isfinite(expected))
+        return std::isnan(expected) ? std::isnan(value) : (value == expected);
+    return std::abs(value - expected) <= 1e-4f * std::max(1.f, std::abs(expected));
+}
+
+static void testSmooths(uint32_t count, uint32_t ticks)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-100, 100);
+    std::vector<RefSmooth> ref(count);
+    std::vector<float> target(count, 0);
+    std::vector<std::unique_ptr<Smooth<SingleMgr>>> single;
+    std::vector<std::unique_ptr<Smooth<ParallelMgr>>> parallel;
+    for (uint32_t i = 0; i < count; ++i) {
+        single.push_back(std::make_unique<Smooth<SingleMgr>>(0.f));
+        parallel.push_back(std::make_unique<Smooth<ParallelMgr>>(0.f));
+    }
+    for (uint32_t tick = 0; tick < ticks; ++tick) {
+        for (uint32_t n = count / 16; n--;) {
+            const uint32_t i = rng() % count;
+            if (rng() % 4) {
+                // Retarget, possibly in the middle of a movement
+                target[i] = dist(rng);
+                const float duration = 0.2f + (rng() % 100) / 100.f;
+                single[i]->set(target[i], duration);
+                parallel[i]->set(target[i], duration);
+                ref[i].set(target[i], duration);
+            } else {
+                const uint32_t j = rng() % count;
+                *single[i] = *single[j];
+                *parallel[i] = *parallel[j];
+                ref[i] = ref[j];
+                target[i] = target[j];
+            }
+        }
+        const float deltaTime = 1.f / 60;
+        SingleMgr::instance->update(deltaTime);
+        ParallelMgr::instance->update(deltaTime);
+        for (uint32_t i = 0; i < count; ++i) {
+            ref[i].update(deltaTime);
+            check(near(*single[i], ref[i].value()), "ASmooth value", tick, i);
+            check(single[i]->isTransiting() == ref[i].moving, "ASmooth transiting", tick, i);
+            check(near(*parallel[i], *single[i]), "ASmooth parallel value", tick, i);
+        }
+    }
+    for (uint32_t tick = 0; tick < 240; ++tick) {
+        SingleMgr::instance->update(1.f / 60);
+        ParallelMgr::instance->update(1.f / 60);
+        for (auto &r : ref)
+            r.update(1.f / 60);
+    }
+    for (uint32_t i = 0; i < count; ++i) {
+        // A value poisoned by such a singularity never complete its movement
+        check(single[i]->isTransiting() == ref[i].moving && parallel[i]->isTransiting() == ref[i].moving, "ASmooth completion", ticks, i);
+        check(near(*single[i], ref[i].value()), "ASmooth final value", ticks, i);
+        // Retargets in the middle of a movement may not land exactly, this is a property of ASmooth::set
+        if (ref[i].fromRest)
+            check(near(*single[i], target[i]), "ASmooth target", ticks, i);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    // More elements than TICK_MGR_CHUNK_SIZE, so parallel updates split batches
+    const uint32_t count = (argc > 1) ? std::atoi(argv[1]) : 5000;
+    const uint32_t ticks = (argc > 2) ? std::atoi(argv[2]) : 500;
+    auto single = std::make_unique<SingleMgr>();
+    auto parallel = std::make_unique<ParallelMgr>();
+    SingleMgr::instance = single.get();
+    ParallelMgr::instance = parallel.get();
+    parallel->setThreadCount(3);
+
+    testFaders(count, ticks);
+    std::cout << "AFader: " << (failures ? "FAILED" : "OK") << std::endl;
+    const int faderFailures = failures;
+    testSmooths(count, ticks);
+    std::cout << "ASmooth: " << (failures > faderFailures ? "FAILED" : "OK") << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+/*
+** EntityCore
+** Test - TickMgr
+** File description:
+** Tickables starting, stopping and destroying each other or themselves from their update, checking every ticking tickable is updated exactly once per tick
+** Build : g++ -std=c++20 -O2 TickMgrTest.cpp -o TickMgrTest -lpthread
+** Usage : ./TickMgrTest [tickables] [ticks]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Executor/TickMgr.hpp"
+#include <iostream>
+#include <random>
+#include <vector>
+#include <memory>
+
+class TestMgr : public TickMgr<TestMgr> {
+public:
+    static inline TestMgr *instance = nullptr;
+};
+
+static uint32_t currentTick = 0;
+static uint32_t doubleUpdates = 0;
+static uint32_t ghostUpdates = 0;
+static std::mt19937 rng(1234);
+
+class Probe;
+static std::vector<std::unique_ptr<Probe>> probes;
+
+class Probe : public Tickable<TestMgr> {
+public:
+    void start() {
+        if (!ticking) {
+            ticking = true;
+            startTick = currentTick;
+            this->needUpdate(TestMgr::instance);
+        }
+    }
+    void stop() {
+        if (ticking) {
+            ticking = false;
+            this->mgr->stopTicking(this);
+            this->mgr = nullptr;
+        }
+    }
+    virtual bool update(float) override {
+        doubleUpdates += (lastTick == currentTick);
+        ghostUpdates += !ticking;
+        lastTick = currentTick;
+        switch (rng() % 16) {
+            case 0: // Stop another tickable, either already updated or not
+                probes[rng() % probes.size()]->stop();
+                break;
+            case 1: // Start another tickable
+                probes[rng() % probes.size()]->start();
+                break;
+            case 2: // Destroy another tickable or itself, ~Tickable stops ticking
+                probes[rng() % probes.size()] = std::make_unique<Probe>();
+                return false; // This may be destroyed, it must not be touched
+            case 3: // Stop itself and report completion
+                ticking = false;
+                this->mgr->stopTicking(this);
+                this->mgr = nullptr;
+                return true;
+            case 4: // Report completion
+                ticking = false;
+                this->mgr = nullptr;
+                return true;
+        }
+        return false;
+    }
+    bool ticking = false;
+    uint32_t startTick = 0;
+    uint32_t lastTick = UINT32_MAX;
+};
+
+int main(int argc, char **argv)
+{
+    const uint32_t count = (argc > 1) ? std::atoi(argv[1]) : 1000;
+    const uint32_t tickCount = (argc > 2) ? std::atoi(argv[2]) : 2000;
+    auto mgr = std::make_unique<TestMgr>();
+    TestMgr::instance = mgr.get();
+    for (uint32_t i = 0; i < count; ++i)
+        probes.push_back(std::make_unique<Probe>());
+
+    uint32_t missedUpdates = 0;
+    for (currentTick = 0; currentTick < tickCount; ++currentTick) {
+        // Keep most tickables ticking
+        for (uint32_t n = count / 8; n--;)
+            probes[rng() % count]->start();
+        TestMgr::instance->update(0.01f);
+        // Tickables ticking for the whole tick must have been updated
+        for (auto &p : probes) {
+            if (p->ticking && p->startTick < currentTick && p->lastTick != currentTick)
+                ++missedUpdates;
+        }
+    }
+    probes.clear();
+    std::cout << tickCount << " ticks of " << count << " tickables\n";
+    std::cout << doubleUpdates << " double updates, " << ghostUpdates << " updates after stopping, " << missedUpdates << " missed updates\n";
+    const bool ok = !doubleUpdates && !ghostUpdates && !missedUpdates;
+    std::cout << (ok ? "OK" : "FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+/*
+** EntityCore
+** Test - UnboundedQueue
+** File description:
+** Stress test of UnboundedQueue with several producers and one consumer, checking the order of each producer, the count and the recycling of segments
+** Build : g++ -std=c++20 -O2 UnboundedQueueTest.cpp -o UnboundedQueueTest -lpthread
+** Usage : ./UnboundedQueueTest [producers] [elements per producer]
+** License:
+** MIT (see https://github.com/Calvin-Ruiz/EntityCore)
+*/
+#include "../Tools/SafeQueue.hpp"
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <memory>
+
+// Non-scalar element, so a partially-moved element would be detected
+// Default-constructed items are the slots of the segments, which count the segments allocated and alive
+struct Item {
+    Item() : inSegment(true) {
+        slotsAllocated.fetch_add(1, std::memory_order_relaxed);
+        slotsAlive.fetch_add(1, std::memory_order_relaxed);
+    }
+    Item(uint32_t producer, uint32_t sequence) : producer(producer), sequence(sequence), payload(makePayload(producer, sequence)) {}
+    Item(const Item &other) : producer(other.producer), sequence(other.sequence), payload(other.payload) {}
+    Item &operator=(const Item &other) {
+        producer = other.producer;
+        sequence = other.sequence;
+        payload = other.payload;
+        return *this;
+    }
+    Item &operator=(Item &&other) {
+        producer = other.producer;
+        sequence = other.sequence;
+        payload = std::move(other.payload);
+        return *this;
+    }
+    ~Item() {
+        if (inSegment)
+            slotsAlive.fetch_sub(1, std::memory_order_relaxed);
+    }
+    static std::string makePayload(uint32_t producer, uint32_t sequence) {
+        return "payload-" + std::to_string(producer) + "-" + std::to_string(sequence) + std::string(sequence % 37, '#');
+    }
+    uint32_t producer = 0;
+    uint32_t sequence = 0;
+    std::string payload;
+    bool inSegment = false; // Not assigned, it stays with the storage
+    static inline std::atomic<uint64_t> slotsAllocated{0};
+    static inline std::atomic<int64_t> slotsAlive{0};
+};
+
+template <unsigned short segmentSize, unsigned short maxFreeSegments>
+using Queue = UnboundedQueue<Item, segmentSize, maxFreeSegments>;
+
+template <unsigned short segmentSize, unsigned short maxFreeSegments>
+static bool stress(int producerCount, uint32_t perProducer)
+{
+    auto queue = std::make_unique<Queue<segmentSize, maxFreeSegments>>();
+    const uint64_t total = (uint64_t) producerCount * perProducer;
+    std::vector<uint32_t> nextSequence(producerCount, 0);
+    uint64_t misordered = 0;
+    uint64_t corrupted = 0;
+    std::vector<std::thread> threads;
+
+    for (int p = 0; p < producerCount; ++p) {
+        threads.emplace_back([&, p]{
+            for (uint32_t i = 0; i < perProducer; ++i) {
+                Item item(p, i);
+                if (i & 1)
+                    queue->push(item);
+                else
+                    queue->emplace(item);
+            }
+        });
+    }
+    Item item(0, 0);
+    for (uint64_t popped = 0; popped < total;) {
+        if (!queue->pop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ++popped;
+        if (item.producer >= (uint32_t) producerCount || item.payload != Item::makePayload(item.producer, item.sequence)) {
+            ++corrupted;
+            continue;
+        }
+        // Elements of a producer are received in insertion order
+        misordered += (item.sequence != nextSequence[item.producer]);
+        nextSequence[item.producer] = item.sequence + 1;
+    }
+    for (auto &t : threads)
+        t.join();
+
+    uint64_t missing = 0;
+    for (int p = 0; p < producerCount; ++p)
+        missing += perProducer - nextSequence[p];
+    const bool success = !misordered && !corrupted && !missing && queue->empty();
+    std::cout << (success ? "OK   " : "FAIL ") << "segment " << segmentSize << ", " << producerCount << " producers, " << total << " elements, " << total / segmentSize << " segments crossed";
+    if (!success)
+        std::cout << " : " << misordered << " misordered, " << corrupted << " corrupted, " << missing << " missing";
+    std::cout << '\n';
+    return success;
+}
+
+// Bursts larger than the free-list, then bursts it can serve, drained by the consumer in between
+template <unsigned short segmentSize, unsigned short maxFreeSegments>
+static bool recycling(int producerCount)
+{
+    auto queue = std::make_unique<Queue<segmentSize, maxFreeSegments>>();
+    const int64_t aliveBefore = Item::slotsAlive.load();
+    auto segmentsAlive = [&]{return (Item::slotsAlive.load() - aliveBefore) / segmentSize;};
+    auto burst = [&](uint32_t perProducer) {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producerCount; ++p) {
+            threads.emplace_back([&, p]{
+                for (uint32_t i = 0; i < perProducer; ++i)
+                    queue->emplace(Item(p, i));
+            });
+        }
+        for (auto &t : threads)
+            t.join();
+        const int64_t peak = segmentsAlive();
+        Item item(0, 0);
+        uint64_t popped = 0;
+        while (queue->pop(item))
+            ++popped;
+        return std::make_pair(peak, popped == (uint64_t) producerCount * perProducer);
+    };
+    bool success = true;
+    // Segments beyond maxFreeSegments are released once consumed
+    int64_t largestPeak = 0;
+    for (int i = 0; i < 20; ++i) {
+        auto [peak, complete] = burst(segmentSize * (maxFreeSegments + 4) / producerCount + 1);
+        success &= complete && segmentsAlive() <= maxFreeSegments + 1;
+        largestPeak = std::max(largestPeak, peak);
+    }
+    success &= largestPeak > maxFreeSegments + 1;
+    // Bursts which fit in the free-list reuse its segments
+    burst(segmentSize * maxFreeSegments / producerCount);
+    const uint64_t allocated = Item::slotsAllocated.load();
+    for (int i = 0; i < 100; ++i) {
+        auto [peak, complete] = burst(segmentSize * maxFreeSegments / producerCount);
+        success &= complete;
+    }
+    const uint64_t reallocated = (Item::slotsAllocated.load() - allocated) / segmentSize;
+    success &= (reallocated == 0);
+    std::cout << (success ? "OK   " : "FAIL ") << "segment " << segmentSize << ", " << maxFreeSegments << " free segments, peak of " << largestPeak << " segments, " << segmentsAlive() << " kept, " << reallocated << " allocated by bursts fitting in the free-list\n";
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    const int producerCount = (argc > 1) ? std::atoi(argv[1]) : 4;
+    const uint32_t perProducer = (argc > 2) ? std::atoi(argv[2]) : 200000;
+    bool success = true;
+    // Tiny segments, so that producers race on linking the next segment
+    success &= stress<3, 2>(producerCount, perProducer / 4);
+    success &= stress<255, 4>(producerCount, perProducer);
+    success &= stress<255, 4>(1, perProducer);
+    success &= recycling<15, 4>(producerCount);
+    success &= recycling<255, 1>(producerCount);
+    // Every segment is released with the queue
+    if (Item::slotsAlive.load() != 0) {
+        std::cout << "FAIL " << Item::slotsAlive.load() << " slots leaked\n";
+        success = false;
+    }
+    return success ? 0 : 1;
+}
@@ -9,15 +9,35 @@
 */
 #include "CaptureMetrics.hpp"
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <bit>
 
-CaptureMetrics::CaptureMetrics(const std::string &filename, const std::vector<std::string> &names) : filename(filename), names(names), pos(0)
+std::atomic<uint32_t> CaptureMetrics::instanceCount {0};
+thread_local uint32_t CaptureMetrics::localOwner = 0;
+thread_local CaptureMetrics::ThreadBuffer *CaptureMetrics::localBuffer = nullptr;
+thread_local std::vector<std::pair<uint32_t, CaptureMetrics::ThreadBuffer *>> CaptureMetrics::localBuffers;
+
+CaptureMetrics::CaptureMetrics(const std::string &filename, const std::vector<std::string> &names) : filename(filename), names(names), id(++instanceCount)
 {
 }
 
 CaptureMetrics::~CaptureMetrics()
 {
-    if (pos & CAPTURE_METRICS_SUBMASK)
-        file.write((char *) ((pos & CAPTURE_METRICS_BUFFER_SIZE) ? buffer : buffer + CAPTURE_METRICS_BUFFER_SIZE), (pos & CAPTURE_METRICS_SUBMASK) * sizeof(TimePoint));
+    active = false;
+    if (writer.joinable()) {
+        mtx.lock();
+        alive = false;
+        mtx.unlock();
+        cv.notify_one();
+        writer.join();
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    flush();
+    for (auto &b : buffers) {
+        if (b->dropped)
+            std::cout << "Thread " << b->thread << " dropped " << b->dropped << " capture points\n";
+    }
 }
 
 void CaptureMetrics::startCapture()
@@ -26,10 +46,11 @@ void CaptureMetrics::startCapture()
         file.open(filename, std::ofstream::out | std::ofstream::binary | std::ofstream::trunc);
         if (file) {
             std::cout << "Starting capture \"" << filename << "\"\n";
+            writer = std::thread(&CaptureMetrics::writerloop, this);
         } else {
             std::cout << "Failed to open \"" << filename << "\" to capture metrics\n";
         }
-        origin = std::chrono::steady_clock::now();
+        origin = std::chrono::steady_clock::now().time_since_epoch().count();
     }
     active = file.good();
 }
@@ -39,95 +60,294 @@ void CaptureMetrics::stopCapture()
     active = false;
 }
 
-void CaptureMetrics::capture(int type)
+void CaptureMetrics::record(int type, Phase phase)
 {
-    if (active) {
-        auto current = std::chrono::steady_clock::now();
-        int p = ++pos & CAPTURE_METRICS_MASK;
-        buffer[p - 1] = {type, std::chrono::duration_cast<std::chrono::duration<float>>(current - origin).count()};
-        if (type == 0)
-            origin = current;
-        if (!(p & CAPTURE_METRICS_SUBMASK)) {
-            file.write((char *) ((p & CAPTURE_METRICS_BUFFER_SIZE) ? buffer : buffer + CAPTURE_METRICS_BUFFER_SIZE), CAPTURE_METRICS_BUFFER_SIZE * sizeof(TimePoint));
+    // Acquire the origin set by startCapture
+    if (active.load(std::memory_order_acquire)) {
+        const auto current = std::chrono::steady_clock::now().time_since_epoch().count();
+        ThreadBuffer &b = (localOwner == id) ? *localBuffer : registerThread();
+        const uint32_t head = b.head.load(std::memory_order_relaxed);
+        if (head - b.cachedTail > CAPTURE_METRICS_MASK) {
+            b.cachedTail = b.tail.load(std::memory_order_acquire);
+            if (head - b.cachedTail > CAPTURE_METRICS_MASK) {
+                ++b.dropped;
+                return;
+            }
         }
+        b.buffer[head & CAPTURE_METRICS_MASK] = {type, b.thread, phase, current - origin};
+        b.head.store(head + 1, std::memory_order_release);
+        if (!((head + 1) & CAPTURE_METRICS_SUBMASK))
+            cv.notify_one();
     }
 }
 
-void CaptureMetrics::analyze()
+CaptureMetrics::ThreadBuffer &CaptureMetrics::registerThread()
+{
+    localOwner = id;
+    for (auto &entry : localBuffers) {
+        if (entry.first == id) {
+            localBuffer = entry.second;
+            return *localBuffer;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mtx);
+    buffers.push_back(std::make_unique<ThreadBuffer>());
+    localBuffer = buffers.back().get();
+    localBuffer->thread = buffers.size() - 1;
+    localBuffers.push_back({id, localBuffer});
+    return *localBuffer;
+}
+
+void CaptureMetrics::nameThread(const std::string &name)
+{
+    ThreadBuffer &b = (localOwner == id) ? *localBuffer : registerThread();
+    std::lock_guard<std::mutex> lock(mtx);
+    b.name = name;
+}
+
+void CaptureMetrics::writerloop()
+{
+    std::unique_lock<std::mutex> lock(mtx);
+    while (alive) {
+        // A notification sent while flushing is lost, hence the timeout
+        cv.wait_for(lock, std::chrono::milliseconds(10));
+        flush();
+    }
+}
+
+void CaptureMetrics::flush()
+{
+    for (auto &b : buffers) {
+        const uint32_t tail = b->tail.load(std::memory_order_relaxed);
+        const uint32_t head = b->head.load(std::memory_order_acquire);
+        if (head == tail)
+            continue;
+        const uint32_t begin = tail & CAPTURE_METRICS_MASK;
+        const uint32_t end = head & CAPTURE_METRICS_MASK;
+        if (begin < end) {
+            file.write((char *) (b->buffer + begin), (end - begin) * sizeof(TimePoint));
+        } else {
+            file.write((char *) (b->buffer + begin), (CAPTURE_METRICS_MASK + 1 - begin) * sizeof(TimePoint));
+            file.write((char *) b->buffer, end * sizeof(TimePoint));
+        }
+        b->tail.store(head, std::memory_order_release);
+    }
+}
+
+void CaptureMetrics::flushFile()
+{
+    if (file.is_open()) {
+        std::lock_guard<std::mutex> lock(mtx);
+        flush();
+        file.flush();
+    }
+}
+
+std::vector<CaptureMetrics::TimePoint> &CaptureMetrics::getPoints()
 {
+    flushFile();
     std::ifstream file(filename, std::ifstream::binary);
+    if (!file)
+        return points;
     file.seekg(0, file.end);
-    points.resize(file.tellg() / sizeof(TimePoint));
-    file.seekg(0, file.beg);
-    file.read((char *) points.data(), points.size());
-    file.close();
-    // Analyze frames
+    const size_t loaded = points.size();
+    const size_t count = file.tellg() / sizeof(TimePoint);
+    if (count > loaded) {
+        // Points captured since are appended, which preserves the capture order of each thread
+        // Frames point to the previous storage, they are rebuilt by the next getFrameMetrics
+        frames.clear();
+        points.resize(count);
+        file.seekg(loaded * sizeof(TimePoint), file.beg);
+        file.read((char *) (points.data() + loaded), (count - loaded) * sizeof(TimePoint));
+    }
+    return points;
+}
+
+std::vector<CaptureMetrics::FrameMetric> &CaptureMetrics::getFrameMetrics()
+{
+    getPoints();
+    if (!frames.empty())
+        return frames;
+    // Gather the marks of the frame thread, preserving the capture order of each thread
+    auto frameStart = std::find_if(points.begin(), points.end(), [](const TimePoint &p){return p.type == 0 && p.phase == MARK;});
+    if (frameStart == points.end())
+        return frames;
+    const int frameThread = frameStart->thread;
+    const auto isFrameMark = [frameThread](const TimePoint &p){return p.thread == frameThread && p.phase == MARK;};
+    std::stable_partition(points.begin(), points.end(), isFrameMark);
     for (auto &p : points) {
+        if (!isFrameMark(p))
+            break;
         if (p.type) {
-            ++frames.back().size;
+            if (!frames.empty())
+                ++frames.back().size;
             continue;
         }
         frames.push_back({&p, 1});
     }
-    // Analyze sequences
-    SequenceMetric sequence {{}, &frames.front(), 0};
-    for (int i = 0; i < frames.front().size; ++i)
-        sequence.types.push_back(frames.front().ptr[i].type);
-    for (auto &f : frames) {
-        bool diff = sequence.ptr->size != f.size;
-        if (!diff) {
-            for (int i = 0; i < f.size; ++i)
-                diff |= sequence.types[i] != f.ptr[i].type;
+    return frames;
+}
+
+void CaptureMetrics::analyze()
+{
+    flushFile();
+    // Release what getPoints and getFrameMetrics loaded, it wouldn't follow this analyze
+    points.clear();
+    points.shrink_to_fit();
+    frames.clear();
+    sequences.clear();
+    statistics.clear();
+    markStatistics.clear();
+    markStatistics.resize(names.size());
+    std::ifstream file(filename, std::ifstream::binary);
+    std::vector<TimePoint> chunk(CAPTURE_METRICS_ANALYZE_CHUNK);
+    std::vector<TimePoint> frame; // Marks of the current frame
+    int frameThread = -1; // Thread capturing the type 0
+    int64_t previousStart = 0;
+    uint64_t frameCount = 0;
+    while (file) {
+        file.read((char *) chunk.data(), chunk.size() * sizeof(TimePoint));
+        const size_t count = file.gcount() / sizeof(TimePoint);
+        for (size_t i = 0; i < count; ++i) {
+            const TimePoint &p = chunk[i];
+            if (p.phase != MARK)
+                continue;
+            if (frameThread == -1) {
+                if (p.type)
+                    continue;
+                frameThread = p.thread;
+            }
+            if (p.thread != frameThread)
+                continue;
+            if (p.type == 0 && !frame.empty()) {
+                analyzeFrame(frame, previousStart, frameCount++);
+                previousStart = frame[0].ticks;
+                frame.clear();
+            }
+            frame.push_back(p);
         }
-        if (diff) {
-            sequences.push_back(sequence);
-            sequence.types.resize(0);
-            sequence.ptr = &f;
-            sequence.size = 0;
-            for (int i = 0; i < f.size; ++i)
-                sequence.types.push_back(f.ptr[i].type);
+    }
+    if (!frame.empty())
+        analyzeFrame(frame, previousStart, frameCount);
+    for (uint32_t i = 0; i < statistics.size(); ++i) {
+        statistics[i].metrics = &sequences[i];
+        for (auto &m : statistics[i].markStat)
+            m.finalize();
+    }
+    for (uint32_t i = 0; i < markStatistics.size(); ++i) {
+        if (markStatistics[i].count) {
+            markStatistics[i].type = i;
+            markStatistics[i].finalize();
         }
-        ++sequence.size;
     }
-    sequences.push_back(sequence);
-    // Perform sequence statistics
-    for (auto &s : sequences) {
+}
+
+// The value of the frame start is the time elapsed since the previous frame start, other values are relative to the frame start
+void CaptureMetrics::analyzeFrame(const std::vector<TimePoint> &frame, int64_t previousStart, uint64_t index)
+{
+    bool diff = sequences.empty() || sequences.back().types.size() != frame.size();
+    for (uint32_t j = 0; !diff && j < frame.size(); ++j)
+        diff = sequences.back().types[j] != frame[j].type;
+    if (diff) {
+        SequenceMetric sequence {{}, index, 0};
         SequenceStatistics ss;
-        ss.metrics = &s;
-        ss.markStat.resize(s.types.size());
-        ss.markStat[0].minRel = 0;
-        for (int i = 0; i < s.size; ++i) {
-            float value = s.ptr[i].ptr[0].datetime;
-            ss.markStat[0].type = s.types[0];
-            ss.markStat[0].avr += value;
-            if (ss.markStat[0].max < value)
-                ss.markStat[0].max = value;
-            if (ss.markStat[0].min > value)
-                ss.markStat[0].min = value;
-            float previous = 0;
-            for (uint32_t j = 1; j < s.types.size(); ++j) {
-                value = s.ptr[i].ptr[j].datetime;
-                const float valueRel = value - previous;
-                previous = value;
-                ss.markStat[j].avr += value;
-                if (ss.markStat[j].max < value)
-                    ss.markStat[j].max = value;
-                if (ss.markStat[j].min > value)
-                    ss.markStat[j].min = value;
-                ss.markStat[j].avrRel += valueRel;
-                if (ss.markStat[j].maxRel < valueRel)
-                    ss.markStat[j].maxRel = valueRel;
-                if (ss.markStat[j].minRel > valueRel)
-                    ss.markStat[j].minRel = valueRel;
-            }
+        ss.markStat.resize(frame.size());
+        for (uint32_t j = 0; j < frame.size(); ++j) {
+            sequence.types.push_back(frame[j].type);
+            ss.markStat[j].type = frame[j].type;
         }
-        for (uint32_t j = 1; j < s.types.size(); ++j) {
-            ss.markStat[j].type = s.types[j];
-            ss.markStat[j].avr /= s.size;
-            ss.markStat[j].avrRel /= s.size;
+        sequences.push_back(std::move(sequence));
+        statistics.push_back(std::move(ss));
+    }
+    ++sequences.back().size;
+    auto &markStat = statistics.back().markStat;
+    const int64_t start = frame[0].ticks;
+    markStat[0].add(start - previousStart, 0);
+    markStatistics[frame[0].type].add(start - previousStart, 0);
+    int64_t previous = start;
+    for (uint32_t j = 1; j < frame.size(); ++j) {
+        const int64_t ticks = frame[j].ticks;
+        markStat[j].add(ticks - start, ticks - previous);
+        markStatistics[frame[j].type].add(ticks - start, ticks - previous);
+        previous = ticks;
+    }
+}
+
+static float toSeconds(int64_t ticks)
+{
+    return std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::steady_clock::duration(ticks)).count();
+}
+
+void CaptureMetrics::MarkStatistics::add(int64_t ticks, int64_t ticksRel)
+{
+    const float value = toSeconds(ticks);
+    const float valueRel = toSeconds(ticksRel);
+    ++count;
+    total += ticks;
+    if (max < value)
+        max = value;
+    if (min > value)
+        min = value;
+    totalRel += ticksRel;
+    if (maxRel < valueRel)
+        maxRel = valueRel;
+    if (minRel > valueRel)
+        minRel = valueRel;
+    histogram.add(ticks);
+    histogramRel.add(ticksRel);
+}
+
+void CaptureMetrics::MarkStatistics::finalize()
+{
+    avr = toSeconds(total / count);
+    avrRel = toSeconds(totalRel / count);
+    for (int i = 0; i < 4; ++i) {
+        percentile[i] = toSeconds(histogram.percentile(percentiles[i]));
+        percentileRel[i] = toSeconds(histogramRel.percentile(percentiles[i]));
+    }
+}
+
+// Values below 32 have their own bucket, the others are identified by their highest bit and the 5 following ones
+void CaptureMetrics::Histogram::add(int64_t ticks)
+{
+    uint32_t idx = 0;
+    if (ticks >= 32) {
+        const int shift = std::bit_width((uint64_t) ticks) - 6;
+        idx = (shift + 1) * 32 + ((ticks >> shift) & 31);
+    } else if (ticks > 0)
+        idx = ticks;
+    if (idx >= buckets.size())
+        buckets.resize(idx + 1);
+    ++buckets[idx];
+    ++count;
+}
+
+int64_t CaptureMetrics::Histogram::percentile(float fraction) const
+{
+    uint64_t rank = std::max<uint64_t>(std::ceil(fraction * count), 1);
+    for (uint32_t idx = 0; idx < buckets.size(); ++idx) {
+        if (buckets[idx] >= rank) {
+            if (idx < 32)
+                return idx;
+            // Middle of the bucket
+            const int shift = idx / 32 - 1;
+            return ((int64_t) (32 + idx % 32) << shift) + ((int64_t) 1 << shift) / 2;
         }
-        statistics.push_back(ss);
+        rank -= buckets[idx];
+    }
+    return 0;
+}
+
+std::vector<uint64_t> CaptureMetrics::Histogram::octaves() const
+{
+    std::vector<uint64_t> ret;
+    for (uint32_t idx = 0; idx < buckets.size(); ++idx) {
+        const uint32_t octave = (idx < 32) ? std::bit_width(idx) : idx / 32 + 5;
+        if (octave >= ret.size())
+            ret.resize(octave + 1);
+        ret[octave] += buckets[idx];
     }
+    return ret;
 }
 
 void CaptureMetrics::display()
@@ -135,10 +355,157 @@ void CaptureMetrics::display()
     std::cout << "========== CAPTURE METRICS ==========";
     for (auto &s : statistics) {
         std::cout << "\nSequence of " << s.metrics->size << " frames\n";
-        std::cout << "minRel\tmaxRel\tavrRel\tmin\tmax\tavr\tname\n";
+        std::cout << "minRel\tmaxRel\tavrRel\tp50Rel\tp90Rel\tp99Rel\tp999Rel\tmin\tmax\tavr\tp50\tp90\tp99\tp999\tname\n";
         for (auto &m : s.markStat) {
-            std::cout << (int) (m.minRel * 1000000) << '\t' << (int) (m.maxRel * 1000000) << '\t' << (int) (m.avrRel * 1000000) << '\t' << (int) (m.min * 1000000) << '\t' << (int) (m.max * 1000000) << '\t' << (int) (m.avr * 1000000) << '\t' << names[m.type] << '\n';
+            std::cout << (int) (m.minRel * 1000000) << '\t' << (int) (m.maxRel * 1000000) << '\t' << (int) (m.avrRel * 1000000) << '\t';
+            for (float p : m.percentileRel)
+                std::cout << (int) (p * 1000000) << '\t';
+            std::cout << (int) (m.min * 1000000) << '\t' << (int) (m.max * 1000000) << '\t' << (int) (m.avr * 1000000) << '\t';
+            for (float p : m.percentile)
+                std::cout << (int) (p * 1000000) << '\t';
+            std::cout << names[m.type] << '\n';
         }
     }
     std::cout << "=====================================\n";
 }
+
+static void writeJsonString(std::ofstream &out, const std::string &str)
+{
+    out << '"';
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            out << '\\';
+        if ((unsigned char) c >= ' ')
+            out << c;
+    }
+    out << '"';
+}
+
+bool CaptureMetrics::exportTrace(const std::string &traceFilename)
+{
+    std::ofstream out(traceFilename, std::ofstream::out | std::ofstream::trunc);
+    if (!out) {
+        std::cout << "Failed to open \"" << traceFilename << "\" to export metrics\n";
+        return false;
+    }
+    getPoints();
+    // Timestamps are in microseconds
+    constexpr double tickToUs = 1000000. * std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+    const char phases[] = {'i', 'B', 'E'};
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        for (auto &b : buffers) {
+            if (b->name.empty())
+                continue;
+            out << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << b->thread << ",\"args\":{\"name\":";
+            writeJsonString(out, b->name);
+            out << "}}";
+            first = false;
+        }
+    }
+    out.precision(3);
+    out << std::fixed;
+    for (auto &p : points) {
+        out << (first ? "\n" : ",\n") << "{\"name\":";
+        writeJsonString(out, names[p.type]);
+        out << ",\"ph\":\"" << phases[p.phase] << "\",\"ts\":" << p.ticks * tickToUs << ",\"pid\":0,\"tid\":" << p.thread;
+        out << ((p.phase == MARK) ? ",\"s\":\"t\"}" : "}");
+        first = false;
+    }
+    out << "\n]}\n";
+    return out.good();
+}
+
+bool CaptureMetrics::dumpCSV(const std::string &csvFilename)
+{
+    std::ofstream out(csvFilename, std::ofstream::out | std::ofstream::trunc);
+    if (!out) {
+        std::cout << "Failed to open \"" << csvFilename << "\" to dump statistics\n";
+        return false;
+    }
+    // Times are in microseconds
+    const auto writeMark = [&](const std::string &sequence, const MarkStatistics &m) {
+        out << sequence << ",\"";
+        for (char c : names[m.type])
+            out << ((c == '"') ? "\"\"" : std::string(1, c));
+        out << "\"," << m.count << ',' << m.min * 1000000 << ',' << m.max * 1000000 << ',' << m.avr * 1000000;
+        for (float p : m.percentile)
+            out << ',' << p * 1000000;
+        out << ',' << m.minRel * 1000000 << ',' << m.maxRel * 1000000 << ',' << m.avrRel * 1000000;
+        for (float p : m.percentileRel)
+            out << ',' << p * 1000000;
+        out << '\n';
+    };
+    out << "sequence,name,count,min,max,avr,p50,p90,p99,p999,minRel,maxRel,avrRel,p50Rel,p90Rel,p99Rel,p999Rel\n";
+    for (uint32_t i = 0; i < statistics.size(); ++i) {
+        for (auto &m : statistics[i].markStat)
+            writeMark(std::to_string(i), m);
+    }
+    for (auto &m : markStatistics) {
+        if (m.count)
+            writeMark("all", m);
+    }
+    return out.good();
+}
+
+bool CaptureMetrics::dumpJSON(const std::string &jsonFilename)
+{
+    std::ofstream out(jsonFilename, std::ofstream::out | std::ofstream::trunc);
+    if (!out) {
+        std::cout << "Failed to open \"" << jsonFilename << "\" to dump statistics\n";
+        return false;
+    }
+    // Times are in microseconds, histograms list the upper bound and the size of each non-empty power-of-two interval
+    constexpr double tickToUs = 1000000. * std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+    const auto writeHistogram = [&](const Histogram &histogram) {
+        const auto octaves = histogram.octaves();
+        bool first = true;
+        out << '[';
+        for (uint32_t i = 0; i < octaves.size(); ++i) {
+            if (octaves[i]) {
+                out << (first ? "[" : ",[") << std::ldexp(tickToUs, i) << ',' << octaves[i] << ']';
+                first = false;
+            }
+        }
+        out << ']';
+    };
+    const auto writeMark = [&](const MarkStatistics &m) {
+        out << "{\"name\":";
+        writeJsonString(out, names[m.type]);
+        out << ",\"count\":" << m.count << ",\"min\":" << m.min * 1000000 << ",\"max\":" << m.max * 1000000 << ",\"avr\":" << m.avr * 1000000;
+        out << ",\"minRel\":" << m.minRel * 1000000 << ",\"maxRel\":" << m.maxRel * 1000000 << ",\"avrRel\":" << m.avrRel * 1000000;
+        out << ",\"percentiles\":{";
+        for (int i = 0; i < 4; ++i)
+            out << (i ? ",\"" : "\"") << percentiles[i] * 100 << "\":" << m.percentile[i] * 1000000;
+        out << "},\"percentilesRel\":{";
+        for (int i = 0; i < 4; ++i)
+            out << (i ? ",\"" : "\"") << percentiles[i] * 100 << "\":" << m.percentileRel[i] * 1000000;
+        out << "},\"histogram\":";
+        writeHistogram(m.histogram);
+        out << ",\"histogramRel\":";
+        writeHistogram(m.histogramRel);
+        out << '}';
+    };
+    out << "{\"sequences\":[";
+    for (uint32_t i = 0; i < statistics.size(); ++i) {
+        out << (i ? ",\n" : "\n") << "{\"frames\":" << statistics[i].metrics->size << ",\"marks\":[";
+        for (uint32_t j = 0; j < statistics[i].markStat.size(); ++j) {
+            out << (j ? ",\n" : "\n");
+            writeMark(statistics[i].markStat[j]);
+        }
+        out << "]}";
+    }
+    out << "],\n\"marks\":[";
+    bool first = true;
+    for (auto &m : markStatistics) {
+        if (m.count) {
+            out << (first ? "\n" : ",\n");
+            writeMark(m);
+            first = false;
+        }
+    }
+    out << "]}\n";
+    return out.good();
+}
@@ -14,13 +14,22 @@
 #include <fstream>
 #include <atomic>
 #include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
 
 // How many capture points must be backed together in writes. Must be a power-of-two.
+// Each capturing thread has a ring of twice this size, the writer thread is woken when half of it is filled
 #define CAPTURE_METRICS_BUFFER_SIZE 2048
 #define CAPTURE_METRICS_MASK (CAPTURE_METRICS_BUFFER_SIZE * 2 - 1)
 #define CAPTURE_METRICS_SUBMASK (CAPTURE_METRICS_BUFFER_SIZE - 1)
+// How many capture points are read at once by analyze
+#define CAPTURE_METRICS_ANALYZE_CHUNK 65536
 
 // Note : The first type is considered as the frame start delimiter
+// Capture can be performed from any thread, each thread write in its own buffer without lock
 class CaptureMetrics {
 public:
     CaptureMetrics(const std::string &filename, const std::vector<std::string> &names);
@@ -33,15 +42,44 @@ public:
     inline void capture(EnumType type) {capture((int) type);}
     // Capture a point, type is the position of the action description in the names vector
     // This have no effect if startCapture have not been called
-    // The first and only the first capture of a frame MUST have a type of 0
-    void capture(int type);
+    // The first and only the first capture of a frame MUST have a type of 0, and all of them must come from the same thread
+    // If the writer thread is late, the point is dropped rather than waiting for it
+    inline void capture(int type) {record(type, MARK);}
+    // Begin a scope, scopes of a thread must be ended in the reverse order they have begun
+    template <class EnumType>
+    inline void beginScope(EnumType type) {record((int) type, BEGIN);}
+    // End the last begun scope of this thread, type must match the one given to beginScope
+    template <class EnumType>
+    inline void endScope(EnumType type) {record((int) type, END);}
+    // Name the calling thread in exported traces
+    void nameThread(const std::string &name);
     // Interrupt capture
     void stopCapture();
 
+    // Capture a scope for the lifetime of this object
+    class Scope {
+    public:
+        template <class EnumType>
+        Scope(CaptureMetrics &owner, EnumType type) : owner(owner), type((int) type) {owner.beginScope(this->type);}
+        ~Scope() {owner.endScope(type);}
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    private:
+        CaptureMetrics &owner;
+        const int type;
+    };
+
     // ========== Internal structures ========== //
+    enum Phase : uint16_t {
+        MARK, // Point captured with capture
+        BEGIN, // Point captured with beginScope
+        END, // Point captured with endScope
+    };
     struct TimePoint {
         int type;
-        float datetime;
+        uint16_t thread; // Capturing thread, in order of their first capture
+        uint16_t phase;
+        int64_t ticks; // steady_clock ticks since the capture start
     };
     struct FrameMetric {
         TimePoint *ptr;
@@ -49,9 +87,28 @@ public:
     };
     struct SequenceMetric {
         std::vector<int> types;
-        FrameMetric *ptr;
+        uint64_t firstFrame; // Index of the first frame in getFrameMetrics()
         int size;
     };
+    // Log-scale histogram of tick counts, with a bounded memory whatever the number of values
+    // Values are grouped by power-of-two, each of them split in 32 buckets, so percentiles are within 3%
+    class Histogram {
+    public:
+        void add(int64_t ticks);
+        // Approximate value below which the given fraction of the values are
+        int64_t percentile(float fraction) const;
+        // Number of values in [2^(i-1), 2^i) ticks for the index i, [0, 1) for the index 0
+        std::vector<uint64_t> octaves() const;
+        inline uint64_t size() const {return count;}
+    private:
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+    };
+    // Fractions reported as percentiles
+    static constexpr float percentiles[4] = {0.5, 0.9, 0.99, 0.999};
+    // Times are in seconds
+    // Rel times are relative to the previous mark of the frame, others to the frame start
+    // For the frame start, the time is relative to the previous frame start
     struct MarkStatistics {
         int type = -1;
         float min = 1000;
@@ -60,6 +117,16 @@ public:
         float minRel = 1000;
         float maxRel = 0;
         float avrRel = 0;
+        float percentile[4]; // Value of each percentiles
+        float percentileRel[4];
+        Histogram histogram;
+        Histogram histogramRel;
+        uint64_t count = 0;
+        int64_t total = 0; // Sums in ticks, so long captures don't lose precision
+        int64_t totalRel = 0;
+        void add(int64_t ticks, int64_t ticksRel);
+        // Compute the averages and the percentiles
+        void finalize();
     };
     struct SequenceStatistics {
         SequenceMetric *metrics;
@@ -68,30 +135,77 @@ public:
 
     // ========== Analyze metrics ========== //
     // Note : Any content obtained from this class became undefined when this class is destroyed.
-    // Perform an analyze.
+    // Perform an analyze. Frames and sequences are built from the points captured with capture by the thread capturing the type 0
+    // The capture is read by chunks, so the memory used doesn't depend on the capture size
+    // Points and frames previously obtained from getPoints and getFrameMetrics are released
     void analyze();
-    // Get the frame metrics
-    std::vector<FrameMetric> &getFrameMetrics() {return frames;}
+    // Export every captured point in the Chrome trace event format, which Perfetto can open
+    // Return false if the file can't be written
+    bool exportTrace(const std::string &traceFilename);
+    // Get every captured point, in capture order for each thread
+    // The whole capture is loaded on the first call, points captured since are appended by the next calls
+    std::vector<TimePoint> &getPoints();
+    // Get the frame metrics, loading the whole capture on the first call
+    // They are rebuilt if the capture has grown since, which invalidates the previous ones
+    std::vector<FrameMetric> &getFrameMetrics();
     // Return the sequences statistics
     std::vector<SequenceStatistics> &getStatistics() {return statistics;}
+    // Return the statistics of each type over every sequence, indexed by type
+    std::vector<MarkStatistics> &getMarkStatistics() {return markStatistics;}
     // Display statistics
     void display();
+    // Write the statistics in CSV, with one line per mark of each sequence, then per mark over every sequence
+    // Return false if the file can't be written
+    bool dumpCSV(const std::string &csvFilename);
+    // Write the statistics and their histograms in JSON
+    // Return false if the file can't be written
+    bool dumpJSON(const std::string &jsonFilename);
 private:
+    // Single producer single consumer ring of one capturing thread
+    struct ThreadBuffer {
+        alignas(64) std::atomic<uint32_t> head {0}; // Written by the capturing thread
+        uint32_t cachedTail = 0; // Last tail seen by the capturing thread
+        uint32_t dropped = 0;
+        uint16_t thread;
+        std::string name;
+        alignas(64) std::atomic<uint32_t> tail {0}; // Written by the writer thread
+        alignas(64) TimePoint buffer[CAPTURE_METRICS_BUFFER_SIZE * 2];
+    };
+    void record(int type, Phase phase);
+    // Return the buffer of the calling thread, registering it on its first capture
+    ThreadBuffer &registerThread();
+    // Write every pending point and flush the file
+    void flushFile();
+    // Add a frame to the current sequence statistics, or start a new sequence
+    void analyzeFrame(const std::vector<TimePoint> &frame, int64_t previousStart, uint64_t index);
+    void writerloop();
+    // Write every pending point to the file, mtx must be locked
+    void flush();
+
     const std::string filename;
     const std::vector<std::string> names;
+    const uint32_t id; // Distinguish instances in thread-local caches
 
     // Capture metrics
     std::ofstream file;
-    std::chrono::steady_clock::time_point origin;
-    TimePoint buffer[CAPTURE_METRICS_BUFFER_SIZE * 2];
-    std::atomic<uint16_t> pos;
-    bool active = false;
+    std::chrono::steady_clock::rep origin;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    std::thread writer;
+    std::mutex mtx; // Guard buffers and file
+    std::condition_variable cv;
+    std::atomic<bool> active {false};
+    bool alive = true;
+    static std::atomic<uint32_t> instanceCount;
+    static thread_local uint32_t localOwner; // Instance of localBuffer
+    static thread_local ThreadBuffer *localBuffer;
+    static thread_local std::vector<std::pair<uint32_t, ThreadBuffer *>> localBuffers; // Buffer of this thread in each instance
 
     // Analyze metrics
     std::vector<TimePoint> points;
     std::vector<FrameMetric> frames;
     std::vector<SequenceMetric> sequences;
     std::vector<SequenceStatistics> statistics;
+    std::vector<MarkStatistics> markStatistics;
 };
 
 #endif /* end of include guard: CAPTURE_METRICS_HPP_ */
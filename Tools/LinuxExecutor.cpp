@@ -8,6 +8,7 @@
 */
 #include "LinuxExecutor.hpp"
 #include <cassert>
+#include <algorithm>
 
 LinuxExecutor *LinuxExecutor::instance = nullptr;
 
@@ -19,6 +20,14 @@ LinuxExecutor *LinuxExecutor::instance = nullptr;
 #include <sys/wait.h>
 #include <unistd.h>
 #include <alloca.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#ifdef LINUX_EXECUTOR_POSIX_SPAWN
+#include <spawn.h>
+#endif
 #include "StrPack.hpp"
 #include "StaticLog.hpp"
 
@@ -30,14 +39,18 @@ LinuxExecutor *LinuxExecutor::instance = nullptr;
 // Define alias
 #define forkMutex requestMutex
 
-LinuxExecutor::LinuxExecutor(int maxInputPipes, int maxOutputPipes)
+// Tag of the epoll events of an instance output, other events are exit notifications
+#define EPOLL_OUTPUT_TAG 1
+
+LinuxExecutor::LinuxExecutor(int maxInputPipes, int maxOutputPipes) :
+    maxInputPipes(maxInputPipes), maxOutputPipes(maxOutputPipes),
+    jobConcurrency(std::max(std::thread::hardware_concurrency(), 1U))
 {
-    assert(maxInputPipes == 0);
-    assert(maxOutputPipes == 0);
 }
 
 LinuxExecutor::~LinuxExecutor()
 {
+    stopJobs();
     if (instance && pid) {
         int status;
         if (!properlyClosed)
@@ -56,7 +69,9 @@ void LinuxExecutor::start(bool fortifyCurrent)
         throw std::system_error(errno, std::system_category(), "pipe");
     if (pipe(pipes + 2) != 0)
         throw std::system_error(errno, std::system_category(), "pipe");
-    processCount = 0;
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0, sockets) != 0)
+        throw std::system_error(errno, std::system_category(), "socketpair");
     pid = fork();
     if (pid == 0) {
         // Internal side
@@ -64,6 +79,13 @@ void LinuxExecutor::start(bool fortifyCurrent)
         ::close(pipes[1]);
         ::close(pipes[2]);
         pipeRequest = pipes[3];
+        fdSocket = sockets[1];
+        ::close(sockets[0]);
+#ifdef LINUX_EXECUTOR_POSIX_SPAWN
+        // Spawned instances don't close them by themselves
+        fcntl(pipeResponse, F_SETFD, FD_CLOEXEC);
+        fcntl(pipeRequest, F_SETFD, FD_CLOEXEC);
+#endif
         mainloop();
         exit(0);
     }
@@ -72,6 +94,8 @@ void LinuxExecutor::start(bool fortifyCurrent)
     pipeRequest = pipes[1];
     pipeResponse = pipes[2];
     ::close(pipes[3]);
+    fdSocket = sockets[0];
+    ::close(sockets[1]);
     instance = this;
     if (fortifyCurrent) {
         for (int fortifyPid = fork(); fortifyPid; fortifyPid = fork()) {
@@ -96,6 +120,8 @@ void LinuxExecutor::compileContext(const ExecutorInfo &info, std::vector<char> &
         while (info.env[head.nbEnvs] != nullptr)
             ++head.nbEnvs;
     }
+    assert(!(info.pipeInput && info.pushInput));
+    assert(!(info.pipeOutput && info.saveOutput));
     head.pipeInput = info.pipeInput;
     head.pipeOutput = info.pipeOutput;
     head.pushInput = info.pushInput;
@@ -133,9 +159,7 @@ ExecutorInstance *LinuxExecutor::spawnInstance(const ExecutorInfo &info, std::ve
     requestMutex.lock();
     cache.clear();
     compileContext(info, cache);
-    instances.emplace_front();
-    auto &ei = instances.front();
-    ei.it = instances.begin();
+    auto &ei = emplaceInstance(info.pipeInput, info.pipeOutput);
     *(void **) (cache.data() + sizeof(unsigned short)) = &ei;
     request(LEFlag::SPAWN, cache, false);
     requestMutex.unlock();
@@ -145,9 +169,7 @@ ExecutorInstance *LinuxExecutor::spawnInstance(const ExecutorInfo &info, std::ve
 ExecutorInstance *LinuxExecutor::spawnInstance(ExecutorContext *context)
 {
     requestMutex.lock();
-    instances.emplace_front();
-    auto &ei = instances.front();
-    ei.it = instances.begin();
+    auto &ei = emplaceInstance(context->pipeInput, context->pipeOutput);
     *(void **) (context->initializer.data() + sizeof(unsigned short)) = &ei;
     request(LEFlag::SPAWN, context->initializer, false);
     requestMutex.unlock();
@@ -160,20 +182,45 @@ ExecutorInstance *LinuxExecutor::spawnInstance(ExecutorContext *context, const V
     StrPack<unsigned short> pack(context->initializer);
     pack.scan();
     pack.rewrite(pushInput.str, pushInput.size, pack.size() - 1);
-    instances.emplace_front();
-    auto &ei = instances.front();
-    ei.it = instances.begin();
+    auto &ei = emplaceInstance(context->pipeInput, context->pipeOutput);
     *(void **) (context->initializer.data() + sizeof(unsigned short)) = &ei;
     request(LEFlag::SPAWN, context->initializer, false);
     requestMutex.unlock();
     return &ei;
 }
 
-void LinuxExecutor::waitInstance(ExecutorInstance *instance)
+ExecutorInstance &LinuxExecutor::emplaceInstance(bool pipeInput, bool pipeOutput)
+{
+    if (pipeInput) {
+        const int count = ++inputPipes;
+        assert(count <= maxInputPipes);
+        (void) count;
+    }
+    if (pipeOutput) {
+        const int count = ++outputPipes;
+        assert(count <= maxOutputPipes);
+        (void) count;
+    }
+    instanceMutex.lock();
+    instances.emplace_front();
+    auto &ei = instances.front();
+    ei.it = instances.begin();
+    instanceMutex.unlock();
+    ei.pipeInput = pipeInput;
+    ei.pipeOutput = pipeOutput;
+    return ei;
+}
+
+void LinuxExecutor::waitSpawn(ExecutorInstance *instance)
 {
     while (!instance->started) {
         std::this_thread::sleep_for(std::chrono::milliseconds(10)); // Keep enough reactivity
     }
+}
+
+void LinuxExecutor::waitInstance(ExecutorInstance *instance)
+{
+    waitSpawn(instance);
     instance->mtx.lock();
     instance->mtx.unlock();
 }
@@ -184,11 +231,115 @@ void LinuxExecutor::closeInstance(ExecutorInstance *instance)
         instance->joinable = false;
         return;
     }
+    releaseInstance(instance);
+}
+
+void LinuxExecutor::releaseInstance(ExecutorInstance *instance)
+{
     if (instance->stdin != -1)
         ::close(instance->stdin);
     if (instance->stdout != -1)
         ::close(instance->stdout);
+    if (instance->pipeInput)
+        --inputPipes;
+    if (instance->pipeOutput)
+        --outputPipes;
+    instanceMutex.lock();
     instances.erase(instance->it);
+    instanceMutex.unlock();
+}
+
+void LinuxExecutor::submitJobs(const std::vector<ExecutorContext *> &contexts, const ExecutorJobCallback &onComplete)
+{
+    jobMutex.lock();
+    if (!jobAlive) {
+        jobMutex.unlock();
+        return;
+    }
+    for (auto *context : contexts) {
+        // The instance of a job is only exposed once completed, its direct pipes would never be used
+        assert(!context->pipeInput && !context->pipeOutput);
+        pendingJobs.push_back({context, onComplete});
+    }
+    if (!jobThread.joinable())
+        jobThread = std::thread(&LinuxExecutor::jobloop, this);
+    jobMutex.unlock();
+    dispatchJobs();
+}
+
+void LinuxExecutor::setJobConcurrency(unsigned int concurrency)
+{
+    jobMutex.lock();
+    jobConcurrency = std::max(concurrency, 1U);
+    jobMutex.unlock();
+    dispatchJobs();
+}
+
+void LinuxExecutor::waitJobs()
+{
+    std::unique_lock<std::mutex> lock(jobMutex);
+    jobCv.wait(lock, [this]{return (runningJobs == 0 && pendingJobs.empty()) || !jobAlive;});
+}
+
+void LinuxExecutor::dispatchJobs()
+{
+    while (true) {
+        jobMutex.lock();
+        if (runningJobs >= jobConcurrency || pendingJobs.empty() || !jobAlive) {
+            jobMutex.unlock();
+            return;
+        }
+        PendingJob job = std::move(pendingJobs.front());
+        pendingJobs.pop_front();
+        ++runningJobs;
+        jobMutex.unlock();
+        requestMutex.lock();
+        auto &ei = emplaceInstance(job.context->pipeInput, job.context->pipeOutput);
+        ei.jobContext = job.context;
+        ei.jobCallback = std::move(job.onComplete);
+        *(void **) (job.context->initializer.data() + sizeof(unsigned short)) = &ei;
+        request(LEFlag::SPAWN, job.context->initializer, false);
+        requestMutex.unlock();
+    }
+}
+
+void LinuxExecutor::jobloop()
+{
+    std::unique_lock<std::mutex> lock(jobMutex);
+    while (true) {
+        completedCv.wait(lock, [this]{return !completedJobs.empty() || !jobAlive;});
+        if (completedJobs.empty())
+            return;
+        ExecutorInstance *instance = completedJobs.front();
+        completedJobs.pop_front();
+        lock.unlock();
+        instance->jobCallback(instance->jobContext, instance);
+        releaseInstance(instance);
+        lock.lock();
+        --runningJobs;
+        lock.unlock();
+        dispatchJobs();
+        lock.lock();
+        if (runningJobs == 0 && pendingJobs.empty())
+            jobCv.notify_all();
+    }
+}
+
+void LinuxExecutor::dropJobs()
+{
+    jobMutex.lock();
+    jobAlive = false;
+    pendingJobs.clear();
+    jobMutex.unlock();
+    completedCv.notify_one();
+    jobCv.notify_all();
+}
+
+void LinuxExecutor::stopJobs()
+{
+    dropJobs();
+    if (jobThread.joinable())
+        jobThread.join();
 }
 
 void LinuxExecutor::discard(ExecutorContext *context)
@@ -206,6 +357,7 @@ bool LinuxExecutor::closed()
     if (properlyClosed) {
         if (thread.joinable())
             thread.join();
+        stopJobs();
         if (instance && pid) {
             int status;
             waitpid(pid, &status, 0);
@@ -224,6 +376,7 @@ void LinuxExecutor::execute(std::vector<char> &datas)
     char **args;
     char **env = nullptr;
     int pipes[4];
+    int streams[4]; // Direct pipes, streams[1] and streams[2] are sent to the external side
 
     head = pack.pop<SpawnHead>();
     args = (char **) alloca((head->nbArgs + 1) * sizeof(char *));
@@ -239,13 +392,30 @@ void LinuxExecutor::execute(std::vector<char> &datas)
         env[head->nbEnvs] = nullptr;
     }
     instance.id = head->id;
+    const bool pipeInput = head->pipeInput;
+    const bool pipeOutput = head->pipeOutput;
+    // Always close-on-exec, the instance mustn't hold the other end of its own pipes
+    if (pipeInput && pipe2(streams, O_CLOEXEC) != 0)
+        throw std::system_error(errno, std::system_category(), "pipe");
+    if (pipeOutput && pipe2(streams + 2, O_CLOEXEC) != 0)
+        throw std::system_error(errno, std::system_category(), "pipe");
+#ifdef LINUX_EXECUTOR_POSIX_SPAWN
+    // Pipes of other instances mustn't leak to this one, it would delay their end-of-file
+    const int pipeFlags = O_CLOEXEC;
+#else
+    const int pipeFlags = 0;
+#endif
     if (head->saveOutput) {
-        if (pipe(pipes) != 0)
+        if (pipe2(pipes, pipeFlags) != 0)
             throw std::system_error(errno, std::system_category(), "pipe");
         instance.stdout = pipes[0];
+        // Only read here, instances spawned later mustn't keep it open
+        fcntl(instance.stdout, F_SETFD, FD_CLOEXEC);
+        fcntl(instance.stdout, F_SETFL, O_NONBLOCK);
     }
+    instance.output.resize(offsetof(ExitData, data));
     if (head->pushInput) {
-        if (pipe(pipes + 2) != 0)
+        if (pipe2(pipes + 2, pipeFlags) != 0)
             throw std::system_error(errno, std::system_category(), "pipe");
         VString pushedData;
         pushedData.size = pack.pop(pushedData.str);
@@ -254,6 +424,52 @@ void LinuxExecutor::execute(std::vector<char> &datas)
                 throw std::system_error(errno, std::system_category(), "write");
         ::close(pipes[3]);
     }
+#ifdef LINUX_EXECUTOR_POSIX_SPAWN
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (head->saveOutput)
+        posix_spawn_file_actions_adddup2(&actions, pipes[1], 1);
+    if (head->pushInput)
+        posix_spawn_file_actions_adddup2(&actions, pipes[2], 0);
+    if (pipeInput)
+        posix_spawn_file_actions_adddup2(&actions, streams[0], 0);
+    if (pipeOutput)
+        posix_spawn_file_actions_adddup2(&actions, streams[3], 1);
+    forkMutex.lock();
+    const bool spawned = (posix_spawn(&instance.pid, args[0], &actions, nullptr, args, env ? env : environ) == 0);
+    posix_spawn_file_actions_destroy(&actions);
+    if (head->saveOutput)
+        ::close(pipes[1]);
+    if (head->pushInput)
+        ::close(pipes[2]);
+    if (!spawned) {
+        // Report it like a forked instance failing to exec
+        if (head->saveOutput)
+            ::close(pipes[0]);
+        if (pipeInput) {
+            ::close(streams[0]);
+            ::close(streams[1]);
+        }
+        if (pipeOutput) {
+            ::close(streams[2]);
+            ::close(streams[3]);
+        }
+        ExecutorInstance *id = head->id;
+        datas.resize(sizeof(SpawnResponse));
+        *(SpawnResponse *) datas.data() = {id, false, false};
+        request(LEFlag::SPAWN, datas, false);
+        datas.resize(offsetof(ExitData, data));
+        ExitData *edata = (ExitData *) datas.data();
+        edata->instance = id;
+        edata->size = 0;
+        edata->exited = true;
+        edata->exitCode = -2;
+        request(LEFlag::EXITED, datas, false);
+        forkMutex.unlock();
+        return;
+    }
+    instancesInternal.push_back(instance);
+#else
     forkMutex.lock();
     instance.pid = fork();
     if (instance.pid) {
@@ -272,12 +488,12 @@ void LinuxExecutor::execute(std::vector<char> &datas)
         if (head->pushInput) {
             dup2(pipes[2], 0);
         }
+        if (pipeInput)
+            dup2(streams[0], 0);
+        if (pipeOutput)
+            dup2(streams[3], 1);
         ::close(pipeRequest);
         ::close(pipeResponse);
-        alive = false;
-        forkMutex.unlock();
-        if (thread.joinable())
-            thread.join();
         if (env) {
             execve(args[0], args, env);
         } else {
@@ -285,17 +501,38 @@ void LinuxExecutor::execute(std::vector<char> &datas)
         }
         exit(-2);
     }
-    if (processCount == 0) {
-        if (thread.joinable())
-            thread.join();
-        ++processCount;
-        thread = std::thread(&LinuxExecutor::instanceMainloop, this);
+#endif
+    auto &registered = instancesInternal.back();
+    registered.pidfd = syscall(SYS_pidfd_open, registered.pid, 0);
+    epoll_event event;
+    event.events = EPOLLIN;
+    if (registered.pidfd != -1) {
+        event.data.u64 = (uint64_t) &registered;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, registered.pidfd, &event);
     } else {
-        ++processCount;
+        // Make instanceMainloop poll for its exit
+        const uint64_t wake = 1;
+        if (write(wakeFd, &wake, sizeof(wake)) != sizeof(wake))
+            std::cerr << "CRITICAL [LinuxExecutor] : FAILED TO WAKE THE INSTANCE THREAD !\n";
     }
-    head = (SpawnHead *) head->id;
-    datas.resize(sizeof(void *));
-    *(void **) datas.data() = head;
+    if (registered.stdout != -1) {
+        event.data.u64 = (uint64_t) &registered | EPOLL_OUTPUT_TAG;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, registered.stdout, &event);
+    }
+    // Hand the other ends of the direct pipes to the external side, before the response expecting them
+    if (pipeInput) {
+        ::close(streams[0]);
+        sendPipe(streams[1]);
+        ::close(streams[1]);
+    }
+    if (pipeOutput) {
+        ::close(streams[3]);
+        sendPipe(streams[2]);
+        ::close(streams[2]);
+    }
+    ExecutorInstance *id = head->id;
+    datas.resize(sizeof(SpawnResponse));
+    *(SpawnResponse *) datas.data() = {id, pipeInput, pipeOutput};
     request(LEFlag::SPAWN, datas, false);
     forkMutex.unlock();
 }
@@ -306,20 +543,23 @@ void LinuxExecutor::mainloopExt()
     while (alive) {
         switch (getRequest(datas)) {
             case LEFlag::SPAWN: {
-                ExecutorInstance *ei = *(ExecutorInstance **) datas.data();
+                SpawnResponse *response = (SpawnResponse *) datas.data();
+                ExecutorInstance *ei = response->instance;
+                if (response->pipeInput)
+                    ei->stdin = receivePipe();
+                if (response->pipeOutput)
+                    ei->stdout = receivePipe();
                 ei->mtx.lock();
                 ei->started = true;
                 break;
             }
             case LEFlag::EXITED: {
                 ExitData *data = (ExitData *) datas.data();
+                // Once unlocked, a non-job instance can be released by its owner at any time
+                const bool job = (data->instance->jobContext != nullptr);
                 if (!data->instance->joinable) {
                     data->instance->mtx.unlock();
-                    if (data->instance->stdin != -1)
-                        ::close(data->instance->stdin);
-                    if (data->instance->stdout != -1)
-                        ::close(data->instance->stdout);
-                    instances.erase(data->instance->it);
+                    releaseInstance(data->instance);
                     break;
                 }
                 if (data->size) {
@@ -330,10 +570,18 @@ void LinuxExecutor::mainloopExt()
                 data->instance->exited = data->exited;
                 data->instance->running = false;
                 data->instance->mtx.unlock();
+                if (job) {
+                    jobMutex.lock();
+                    completedJobs.push_back(data->instance);
+                    jobMutex.unlock();
+                    completedCv.notify_one();
+                }
                 break;
             }
             case LEFlag::CLOSE:
             case LEFlag::CLOSED:
+                // Running jobs will never report their completion
+                dropJobs();
                 alive = false;
                 properlyClosed = true;
                 break;
@@ -345,6 +593,15 @@ void LinuxExecutor::mainloopExt()
 void LinuxExecutor::mainloop()
 {
     std::vector<char> datas;
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_CLOEXEC);
+    if (epollFd == -1 || wakeFd == -1)
+        throw std::system_error(errno, std::system_category(), "epoll");
+    epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+    thread = std::thread(&LinuxExecutor::instanceMainloop, this);
     while (alive) {
         switch (getRequest(datas)) {
             case LEFlag::SPAWN:
@@ -358,6 +615,12 @@ void LinuxExecutor::mainloop()
             default:;
         }
     }
+    forkMutex.lock();
+    alive = false;
+    forkMutex.unlock();
+    const uint64_t wake = 1;
+    if (write(wakeFd, &wake, sizeof(wake)) != sizeof(wake))
+        std::cerr << "CRITICAL [LinuxExecutor] : FAILED TO WAKE THE INSTANCE THREAD !\n";
     if (thread.joinable())
         thread.join();
     request(LEFlag::CLOSED);
@@ -365,45 +628,129 @@ void LinuxExecutor::mainloop()
 
 void LinuxExecutor::instanceMainloop()
 {
-    int status;
+    epoll_event events[64];
+    bool polling = false; // Some instance have no pidfd to tell its exit
 
-    do {
-        int pidHit = waitpid(-1, &status, 0);
+    while (true) {
+        const int count = epoll_wait(epollFd, events, 64, polling ? 10 : -1);
+        if (count < 0 && errno != EINTR)
+            throw std::system_error(errno, std::system_category(), "epoll_wait");
         forkMutex.lock();
         if (alive == false) {
             forkMutex.unlock();
             return;
         }
-        if (pidHit == pid) {
-            // The fortified process has exited
-        } else {
-            // A child process has existed
-            instancesInternal.remove_if([this, pidHit, status](auto &instance){
-                if (instance.pid != pidHit)
-                    return false;
-                std::vector<char> datas(offsetof(ExitData, data));
-                ExitData *edata = (ExitData *) datas.data();
-                edata->instance = instance.id;
-                edata->exited = WIFEXITED(status);
-                edata->exitCode = (edata->exited) ? WEXITSTATUS(status) : WTERMSIG(status);
-                if (instance.stdout != -1) {
-                    int currentSize = datas.size();
-                    int size;
-                    do {
-                        datas.resize(currentSize + PIPE_BUF);
-                        size = read(instance.stdout, datas.data() + currentSize, PIPE_BUF);
-                        currentSize += size;
-                    } while (size == PIPE_BUF);
-                    datas.resize(currentSize);
-                    ((ExitData *) datas.data())->size = datas.size() - offsetof(ExitData, data);
-                } else
-                    edata->size = 0;
-                request(LEFlag::EXITED, datas, false);
-                return true;
-            });
+        for (int i = 0; i < count; ++i) {
+            const uint64_t data = events[i].data.u64;
+            if (data == 0) {
+                uint64_t wake;
+                if (read(wakeFd, &wake, sizeof(wake)) != sizeof(wake))
+                    std::cerr << "CRITICAL [LinuxExecutor] : FAILED TO READ WAKE-UP !\n";
+                continue;
+            }
+            auto &instance = *(ExecutorInstanceInternal *) (data & ~(uint64_t) EPOLL_OUTPUT_TAG);
+            if (data & EPOLL_OUTPUT_TAG)
+                drainOutput(instance);
+            else
+                completeInstance(instance);
+        }
+        polling = false;
+        for (auto &instance : instancesInternal) {
+            if (instance.pidfd == -1 && instance.pid != -1) {
+                completeInstance(instance);
+                polling |= (instance.pid != -1);
+            }
         }
+        // Completed instances are only removed now, as they may appear in several events
+        instancesInternal.remove_if([](auto &instance){return instance.pid == -1;});
         forkMutex.unlock();
-    } while (--processCount);
+    }
+}
+
+void LinuxExecutor::drainOutput(ExecutorInstanceInternal &instance)
+{
+    if (instance.stdout == -1)
+        return;
+    while (true) {
+        const size_t currentSize = instance.output.size();
+        instance.output.resize(currentSize + PIPE_BUF);
+        const ssize_t size = read(instance.stdout, instance.output.data() + currentSize, PIPE_BUF);
+        instance.output.resize(currentSize + ((size > 0) ? size : 0));
+        if (size == 0) {
+            // End of file, which would stay readable
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, instance.stdout, nullptr);
+            return;
+        }
+        if (size < 0)
+            return;
+    }
+}
+
+void LinuxExecutor::completeInstance(ExecutorInstanceInternal &instance)
+{
+    int status;
+    if (instance.pid == -1 || waitpid(instance.pid, &status, WNOHANG) != instance.pid)
+        return;
+    if (instance.stdout != -1) {
+        // What the instance wrote before exiting is already in the pipe
+        drainOutput(instance);
+        // A forked instance may still hold it until exec, so closing it wouldn't unregister it
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, instance.stdout, nullptr);
+        ::close(instance.stdout);
+        instance.stdout = -1;
+    }
+    if (instance.pidfd != -1) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, instance.pidfd, nullptr);
+        ::close(instance.pidfd);
+    }
+    ExitData *edata = (ExitData *) instance.output.data();
+    edata->instance = instance.id;
+    edata->exited = WIFEXITED(status);
+    edata->exitCode = (edata->exited) ? WEXITSTATUS(status) : WTERMSIG(status);
+    edata->size = instance.output.size() - offsetof(ExitData, data);
+    request(LEFlag::EXITED, instance.output, false);
+    instance.pid = -1;
+}
+
+void LinuxExecutor::sendPipe(int fd)
+{
+    char byte = 0;
+    iovec iov = {&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    std::memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    if (sendmsg(fdSocket, &msg, 0) == -1)
+        throw std::system_error(errno, std::system_category(), "sendmsg");
+}
+
+int LinuxExecutor::receivePipe()
+{
+    char byte;
+    iovec iov = {&byte, 1};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg {};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(fdSocket, &msg, MSG_CMSG_CLOEXEC) == -1)
+        throw std::system_error(errno, std::system_category(), "recvmsg");
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS) {
+        std::cerr << "CRITICAL [LinuxExecutor] : FAILED TO RECEIVE PIPE !\n";
+        return -1;
+    }
+    int fd;
+    std::memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
 }
 
 void LinuxExecutor::request(LEFlag request, const std::vector<char> &datas, bool requestShouldLock)
@@ -442,7 +789,7 @@ LEFlag LinuxExecutor::getRequest(std::vector<char> &datas)
 
 #include <iostream>
 
-LinuxExecutor::LinuxExecutor(int maxInputPipes, int maxOutputPipes) {(void) maxInputPipes; (void) maxOutputPipes;}
+LinuxExecutor::LinuxExecutor(int maxInputPipes, int maxOutputPipes) : maxInputPipes(maxInputPipes), maxOutputPipes(maxOutputPipes), jobConcurrency(1) {}
 LinuxExecutor::~LinuxExecutor() {instance = nullptr;}
 void LinuxExecutor::start(bool fortifyCurrent) {
     std::cerr << "LinuxExecutor only work under linux\n";
@@ -453,9 +800,18 @@ void LinuxExecutor::rewriteContext(ExecutorContext *context, const ExecutorInfo
 ExecutorInstance *LinuxExecutor::spawnInstance(const ExecutorInfo &info, std::vector<char> &cache) {return new ExecutorInstance();}
 ExecutorInstance *LinuxExecutor::spawnInstance(ExecutorContext *context) {return new ExecutorInstance();}
 ExecutorInstance *LinuxExecutor::spawnInstance(ExecutorContext *context, const VString &pushInput) {return new ExecutorInstance();}
+void LinuxExecutor::waitSpawn(ExecutorInstance *instance) {}
 void LinuxExecutor::waitInstance(ExecutorInstance *instance) {}
 void LinuxExecutor::closeInstance(ExecutorInstance *instance) {delete instance;}
 void LinuxExecutor::discard(ExecutorContext *context) {}
+void LinuxExecutor::submitJobs(const std::vector<ExecutorContext *> &contexts, const ExecutorJobCallback &onComplete) {
+    for (auto *context : contexts) {
+        ExecutorInstance instance;
+        onComplete(context, &instance);
+    }
+}
+void LinuxExecutor::setJobConcurrency(unsigned int concurrency) {}
+void LinuxExecutor::waitJobs() {}
 void LinuxExecutor::close() {}
 bool LinuxExecutor::closed() {return true;}
 void LinuxExecutor::compileContext(const ExecutorInfo &info, std::vector<char> &compiled) {}
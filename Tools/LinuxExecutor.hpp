@@ -13,12 +13,20 @@
 #include <string>
 #include <memory>
 #include <list>
+#include <deque>
 #include <vector>
+#include <functional>
+#include <condition_variable>
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include "VString.hpp"
 
-// Note : direct pipes (pipeInput/pipeOutput) is not supported yet
+// Spawn instances with posix_spawn instead of fork, so spawning don't copy the page tables of the executor process
+// Define LINUX_EXECUTOR_FORK to spawn them with fork instead
+#ifndef LINUX_EXECUTOR_FORK
+#define LINUX_EXECUTOR_POSIX_SPAWN
+#endif
 
 enum class LEFlag : unsigned char {
     SPAWN,
@@ -32,7 +40,9 @@ struct ExecutorInfo {
     const char **args = nullptr;
     const char **env = nullptr;
     VString pushedInput;
+    // Stream stdin through ExecutorInstance::stdin, exclusive with pushInput
     bool pipeInput = false;
+    // Stream stdout through ExecutorInstance::stdout, exclusive with saveOutput
     bool pipeOutput = false;
     // Push an input as stdin
     bool pushInput = false;
@@ -51,8 +61,14 @@ struct ExecutorContext {
 #undef stdin
 #undef stdout
 
+struct ExecutorInstance;
+// Callback of a completed job, called from the job thread, the instance is released once it return
+typedef std::function<void(ExecutorContext *context, ExecutorInstance *instance)> ExecutorJobCallback;
+
 struct ExecutorInstance {
     std::vector<char> output; // Reading this is unsafe and undefined until passed to LinuxExecutor::waitInstance
+    // Direct pipes to the instance, valid once passed to LinuxExecutor::waitSpawn
+    // Closing stdin send end-of-file to the instance, set it to -1 after closing it
     int stdin = -1;
     int stdout = -1;
     char exitCode = -1;
@@ -63,6 +79,10 @@ struct ExecutorInstance {
     bool running = true;
     bool joinable = true;
     bool started = false;
+    bool pipeInput = false;
+    bool pipeOutput = false;
+    ExecutorContext *jobContext = nullptr; // Set if this instance is a job
+    ExecutorJobCallback jobCallback;
 };
 
 class LinuxExecutor {
@@ -85,12 +105,23 @@ public:
     ExecutorInstance *spawnInstance(ExecutorContext *context);
     // Spawn an instance of the executor context with modified push data
     ExecutorInstance *spawnInstance(ExecutorContext *context, const VString &pushInput);
+    // Wait for the instance to be spawned, after which stdin and stdout are valid
+    void waitSpawn(ExecutorInstance *instance);
     // Wait for the instance to complete executions
     void waitInstance(ExecutorInstance *instance);
     // Release the resources allocated for this instance
     void closeInstance(ExecutorInstance *instance);
     // Destroy an executor context
     void discard(ExecutorContext *context);
+    // Queue the execution of every context, with at most jobConcurrency instances running at once
+    // onComplete is called for each of them once completed, contexts must be valid until then
+    // Contexts must not use pipeInput nor pipeOutput, the instance of a job is only exposed once completed
+    // Jobs not completed when the Linux Executor close are dropped without calling onComplete
+    void submitJobs(const std::vector<ExecutorContext *> &contexts, const ExecutorJobCallback &onComplete);
+    // Set the maximal number of concurrently running jobs, default to the number of cores
+    void setJobConcurrency(unsigned int concurrency);
+    // Wait for every submitted job to complete, or to be dropped
+    void waitJobs();
     // Close the Linux Executor
     void close();
     // Tell if the Linux Executor have been successfully closed yet
@@ -98,10 +129,16 @@ public:
 private:
     // Compile an execution context for submission
     void compileContext(const ExecutorInfo &info, std::vector<char> &compiled);
+    // Register a new instance
+    ExecutorInstance &emplaceInstance(bool pipeInput, bool pipeOutput);
+    // Close the pipes of an instance and release it
+    void releaseInstance(ExecutorInstance *instance);
     struct ExecutorInstanceInternal {
         ExecutorInstance *id;
-        int pid;
+        int pid; // -1 once completed
+        int pidfd = -1; // Readable once exited, -1 if pidfd is not supported
         int stdout = -1; // If output must be saved
+        std::vector<char> output; // ExitData of this instance, collecting the output
     };
     struct ExecutorMsgHead {
         uint64_t size;
@@ -116,6 +153,11 @@ private:
         bool pushInput;
         bool saveOutput;
     };
+    struct SpawnResponse {
+        ExecutorInstance *instance;
+        bool pipeInput; // The stdin pipe is sent through fdSocket
+        bool pipeOutput; // The stdout pipe is sent through fdSocket, after the stdin one
+    };
     struct ExitData {
         ExecutorInstance *instance;
         uint64_t size;
@@ -125,7 +167,12 @@ private:
     };
     int pipeRequest;
     int pipeResponse;
+    int fdSocket; // Transfer the direct pipes from the internal side with SCM_RIGHTS
     int pid;
+    const int maxInputPipes;
+    const int maxOutputPipes;
+    std::atomic<int> inputPipes = 0;
+    std::atomic<int> outputPipes = 0;
     std::thread thread;
     bool alive = false;
     bool properlyClosed = false;
@@ -133,14 +180,42 @@ private:
     void request(LEFlag request, const std::vector<char> &datas = {}, bool requestShouldLock = true);
     LEFlag getRequest(std::vector<char> &datas);
     std::mutex requestMutex;
+    // Guard instances, never held while writing requests as mainloopExt can lock it
+    std::mutex instanceMutex;
     std::list<ExecutorInstance> instances;
     void mainloopExt();
+    int receivePipe();
+    struct PendingJob {
+        ExecutorContext *context;
+        ExecutorJobCallback onComplete;
+    };
+    // Spawn pending jobs while below jobConcurrency, must not be called from mainloopExt
+    void dispatchJobs();
+    // Complete the jobs reported by mainloopExt, which can't write requests without risking a deadlock
+    void jobloop();
+    // Drop pending jobs and stop waiting for running ones, waitJobs returns
+    void dropJobs();
+    void stopJobs();
+    std::deque<PendingJob> pendingJobs;
+    std::deque<ExecutorInstance *> completedJobs;
+    std::thread jobThread;
+    // Guard the job queues, never held while writing requests as mainloopExt can lock it
+    std::mutex jobMutex;
+    std::condition_variable jobCv; // Notified once every job has completed
+    std::condition_variable completedCv; // Notified when a job is completed
+    unsigned int jobConcurrency;
+    unsigned int runningJobs = 0;
+    bool jobAlive = true;
     // Internal side only
     void execute(std::vector<char> &datas);
     void mainloop();
     void instanceMainloop();
+    void drainOutput(ExecutorInstanceInternal &instance);
+    void completeInstance(ExecutorInstanceInternal &instance);
+    void sendPipe(int fd);
     std::list<ExecutorInstanceInternal> instancesInternal;
-    int processCount;
+    int epollFd = -1; // Multiplex output and exit of every instance
+    int wakeFd = -1; // Wake instanceMainloop on close
     //std::mutex forkMutex; // Alias of requestMutex
 };
 
@@ -12,10 +12,16 @@
 #define SAFEQUEUE_HPP_
 
 #include <atomic>
-#include <condition_variable>
 #include <mutex>
 #include <thread>
 #include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+// Indices written by different threads are kept on separate cache lines of this size
+#ifndef SAFEQUEUE_CACHE_LINE
+#define SAFEQUEUE_CACHE_LINE 64
+#endif
 
 #define NO_STD20_FEATURES
 #ifndef NO_STD20_FEATURES
@@ -73,11 +79,11 @@ public:
         return writeIdx - readIdx;
     }
 private:
-    std::atomic<uint16_t> readIdx;
-    std::atomic<uint16_t> writeIdx;
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<uint16_t> readIdx;
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<uint16_t> writeIdx;
     std::counting_semaphore<capacity> readSem;
     std::counting_semaphore<capacity> writeSem;
-    volatile T datas[capacity + 1];
+    alignas(SAFEQUEUE_CACHE_LINE) volatile T datas[capacity + 1];
 };
 
 // Thread-safe blocking-pop queue, with undefined behaviour when push-ing while size() >= capacity
@@ -119,14 +125,134 @@ public:
         return writeIdx - readIdx;
     }
 private:
-    std::atomic<uint16_t> readIdx;
-    std::atomic<uint16_t> writeIdx;
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<uint16_t> readIdx;
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<uint16_t> writeIdx;
     std::counting_semaphore<capacity> readSem;
-    volatile T datas[capacity + 1];
+    alignas(SAFEQUEUE_CACHE_LINE) volatile T datas[capacity + 1];
 };
 
 #endif
 
+// Lock-free multi-producer multi-consumer queue, for any movable type T
+// Each slot hold a sequence number telling whether it is ready for push or for pop at the current lap,
+// so an element is never extracted before being fully inserted
+// capacity MUST be a power-of-two
+template<class T, unsigned int capacity = 256>
+class MPMCQueue {
+    static_assert(capacity >= 2 && !(capacity & (capacity - 1)), "capacity must be a power-of-two");
+public:
+    MPMCQueue() : writeIdx(0), readIdx(0) {
+        for (unsigned int i = 0; i < capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    ~MPMCQueue() = default;
+    // Insert element to thread-safe queue, return true on success
+    bool push(T &data) {
+        Cell *cell = acquirePush();
+        if (!cell)
+            return false;
+        cell->data = std::move(data);
+        publish(cell);
+        return true;
+    }
+    bool emplace(const T &data) {
+        Cell *cell = acquirePush();
+        if (!cell)
+            return false;
+        cell->data = data;
+        publish(cell);
+        return true;
+    }
+    // Extract element from thread-safe queue, return true on success
+    bool pop(T &data) {
+        size_t idx = readIdx.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[idx & (capacity - 1)];
+            const intptr_t diff = cell.sequence.load(std::memory_order_acquire) - (idx + 1);
+            if (diff == 0) {
+                if (readIdx.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed)) {
+                    data = std::move(cell.data);
+                    cell.sequence.store(idx + capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Empty
+            } else
+                idx = readIdx.load(std::memory_order_relaxed);
+        }
+    }
+    // Approximative number of elements when used concurrently
+    size_t size() const {
+        const size_t rd = readIdx.load(std::memory_order_relaxed);
+        const size_t wr = writeIdx.load(std::memory_order_relaxed);
+        return (wr > rd) ? wr - rd : 0;
+    }
+    bool empty() const {
+        return size() == 0;
+    }
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+    // Reserve a cell for insertion, or return nullptr if full
+    Cell *acquirePush() {
+        size_t idx = writeIdx.load(std::memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[idx & (capacity - 1)];
+            const intptr_t diff = cell.sequence.load(std::memory_order_acquire) - idx;
+            if (diff == 0) {
+                if (writeIdx.compare_exchange_weak(idx, idx + 1, std::memory_order_relaxed))
+                    return &cell;
+            } else if (diff < 0) {
+                return nullptr; // Full
+            } else
+                idx = writeIdx.load(std::memory_order_relaxed);
+        }
+    }
+    // Make a reserved cell available for pop, its sequence is the index of the push owning it
+    void publish(Cell *cell) {
+        cell->sequence.store(cell->sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<size_t> writeIdx;
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<size_t> readIdx;
+    alignas(SAFEQUEUE_CACHE_LINE) Cell cells[capacity];
+};
+
+// Blocking primitive for the lock-free queues, only issuing a syscall when a thread is actually parked
+// The publication of the awaited condition and its checking must use sequentially consistent atomic operations
+class AtomicWaiter {
+public:
+    // Park the calling thread until ready() return true
+    template<class Pred>
+    void wait(Pred ready) {
+        while (!ready()) {
+            const unsigned int ticket = epoch.load();
+            ++waiters;
+            if (!ready())
+                epoch.wait(ticket);
+            --waiters;
+        }
+    }
+    // Wake one parked thread, if any
+    inline void notifyOne() {
+        if (waiters) {
+            ++epoch;
+            epoch.notify_one();
+        }
+    }
+    // Wake every parked thread, if any
+    inline void notifyAll() {
+        if (waiters) {
+            ++epoch;
+            epoch.notify_all();
+        }
+    }
+private:
+    std::atomic<unsigned int> epoch{0};
+    std::atomic<unsigned int> waiters{0};
+};
+
 // For thread-safe queue for insertion, the following data race might occur :
 // If an insertion operation start
 // A second insertion operation start and complete
@@ -147,7 +273,7 @@ public:
         }
         datas[++writeIdx % (capacity + 1)] = std::move(data);
         if (!count++)
-            cv.notify_one();
+            waiter.notifyOne();
         return true;
     }
     bool emplace(const T &data) {
@@ -157,7 +283,7 @@ public:
         }
         datas[++writeIdx % (capacity + 1)] = data;
         if (!count++)
-            cv.notify_one();
+            waiter.notifyOne();
         return true;
     }
     bool pushRaw(const void *data) {
@@ -167,15 +293,34 @@ public:
         }
         std::memcpy(datas[++writeIdx % (capacity + 1)], data, sizeof(T));
         if (!count++)
-            cv.notify_one();
+            waiter.notifyOne();
         return true;
     }
+    // Insert up to size elements with a single reservation and at most one wake-up
+    // return the number of inserted elements, which are the first ones of data
+    unsigned short pushBatch(T *data, unsigned short size) {
+        unsigned int used = vcount.load(std::memory_order_relaxed);
+        unsigned int accepted;
+        do {
+            if (used >= capacity)
+                return 0;
+            accepted = std::min<unsigned int>(size, capacity - used);
+        } while (!vcount.compare_exchange_weak(used, used + accepted));
+        const unsigned short base = writeIdx.fetch_add(accepted);
+        for (unsigned int i = 0; i < accepted; ++i)
+            datas[(unsigned short) (base + 1 + i) % (capacity + 1)] = std::move(data[i]);
+        if (!count.fetch_add(accepted))
+            waiter.notifyOne();
+        return accepted;
+    }
     // Extract element from queue, return true on success, or false on failure if non-blocking
     bool pop(T &data) {
         while (blocking) {
             if (count)
                 goto EXTRACT;
-            cv.wait(lock);
+            lock.unlock();
+            waiter.wait([this]{return count || !blocking;});
+            lock.lock();
         }
         if (!count)
             return false;
@@ -191,7 +336,9 @@ public:
         while (blocking) {
             if (count)
                 goto EXTRACT;
-            cv.wait(lock);
+            lock.unlock();
+            waiter.wait([this]{return count || !blocking;});
+            lock.lock();
         }
         if (!count)
             return false;
@@ -201,6 +348,26 @@ public:
         --count;
         return true;
     }
+    // Extract up to size elements from queue, return the number of extracted elements
+    // Only return 0 if non-blocking
+    unsigned short popBatch(T *data, unsigned short size) {
+        while (blocking) {
+            if (count)
+                goto EXTRACT;
+            lock.unlock();
+            waiter.wait([this]{return count || !blocking;});
+            lock.lock();
+        }
+        if (!count)
+            return 0;
+        EXTRACT:
+        const unsigned short extracted = std::min<unsigned short>(size, count);
+        for (unsigned short i = 0; i < extracted; ++i)
+            data[i] = std::move(datas[++readIdx % (capacity + 1)]);
+        vcount -= extracted;
+        count -= extracted;
+        return extracted;
+    }
     unsigned short size() const {
         return count;
     }
@@ -220,12 +387,12 @@ public:
     }
     // Enfore the worker thread to check for work
     void flush() {
-        cv.notify_one();
+        waiter.notifyOne();
     }
     // Make the pop call non-blocking, mostly usefull to close a worker thread
     void close() {
         blocking = false;
-        cv.notify_one();
+        waiter.notifyOne();
     }
     // Wait for the queue to complete operations, or wait for .release()
     void waitIdle() {
@@ -233,7 +400,7 @@ public:
         mtx.lock();
         if (count && blocking) {
             mtx.unlock();
-            cv.notify_one();
+            waiter.notifyOne();
             std::this_thread::sleep_for(std::chrono::microseconds(100));
             goto WAIT_JOIN;
         }
@@ -284,14 +451,17 @@ private:
         *(buffer++) = '0' + value % 10;
     }
     T datas[capacity + 1];
-    unsigned short readIdx = 0;
-    std::atomic<unsigned short> writeIdx;
-    std::atomic<unsigned short> count;
-    std::atomic<unsigned int> vcount;
-    bool blocking = false;
-    std::condition_variable cv;
-    std::mutex mtx;
+    // Consumer side
+    alignas(SAFEQUEUE_CACHE_LINE) unsigned short readIdx = 0;
+    std::atomic<bool> blocking = false;
+    std::mutex mtx; // Owned by the consumer while not parked
     std::unique_lock<std::mutex> lock;
+    // Producer side
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<unsigned short> writeIdx;
+    // Shared
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<unsigned short> count;
+    std::atomic<unsigned int> vcount;
+    AtomicWaiter waiter; // Parking of the consumer when empty
 };
 
 // Mostly thread-safe queue for insertion (maximal capacity of 65535 elements)
@@ -379,9 +549,9 @@ private:
         *(buffer++) = '0' + value % 10;
     }
     T datas[capacity + 1];
-    unsigned short readIdx = 0;
-    std::atomic<unsigned short> writeIdx;
-    std::atomic<unsigned short> count;
+    alignas(SAFEQUEUE_CACHE_LINE) unsigned short readIdx = 0; // Consumer side
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<unsigned short> writeIdx; // Producer side
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<unsigned short> count;
     std::atomic<unsigned int> vcount;
 };
 
@@ -393,7 +563,7 @@ public:
     ~PopQueue() = default;
     // Insert element to queue, return true on success
     bool push(T &data) {
-        if (count >= capacity)
+        if (!reserve(1))
             return false;
         datas[++writeIdx % (capacity + 1)] = std::move(data);
         ++count;
@@ -448,10 +618,22 @@ private:
             traceNbr(value / 10, buffer);
         *(buffer++) = '0' + value % 10;
     }
+    // Reserve up to size slots, only reading the shared count once the known free slots are exhausted
+    inline unsigned short reserve(unsigned short size) {
+        if (writeFree < size)
+            writeFree = capacity - count;
+        if (size > writeFree)
+            size = writeFree;
+        writeFree -= size;
+        return size;
+    }
     T datas[capacity + 1];
-    std::atomic<unsigned short> readIdx;
-    unsigned short writeIdx;
-    std::atomic<unsigned short> count;
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<unsigned short> readIdx; // Consumer side
+    // Producer side
+    alignas(SAFEQUEUE_CACHE_LINE) unsigned short writeIdx;
+    unsigned short writeFree = 0; // Lower bound of the free slots, as consumers only release slots
+    // Shared
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<unsigned short> count;
     std::atomic<int> vcount;
 };
 
@@ -468,24 +650,38 @@ public:
     ~DispatchInQueue() = default;
     // Insert element to queue, return true on success
     bool push(T &data) {
-        if (count >= capacity)
+        if (!reserve(1))
             return false;
         datas[++writeIdx % (capacity + nbWorker)] = std::move(data);
         ++count;
         ++vcount;
-        cv.notify_one();
+        waiter.notifyOne();
         return true;
     }
     // Insert element to queue, return true on success
     bool emplace(const T &data) {
-        if (count >= capacity)
+        if (!reserve(1))
             return false;
         datas[++writeIdx % (capacity + nbWorker)] = data;
         ++count;
         ++vcount;
-        cv.notify_one();
+        waiter.notifyOne();
         return true;
     }
+    // Insert up to size elements to queue with a single publication and wake-up
+    // return the number of inserted elements, which are the first ones of data
+    unsigned short pushBatch(T *data, unsigned short size) {
+        const unsigned short accepted = reserve(size);
+        for (unsigned short i = 0; i < accepted; ++i)
+            datas[++writeIdx % (capacity + nbWorker)] = std::move(data[i]);
+        count += accepted;
+        vcount += accepted;
+        if (accepted > 1)
+            waiter.notifyAll();
+        else if (accepted)
+            waiter.notifyOne();
+        return accepted;
+    }
     unsigned short size() const {
         return count;
     }
@@ -494,13 +690,13 @@ public:
     }
     void close() {
         blocking = false;
-        cv.notify_all();
+        waiter.notifyAll();
     }
     void reopen() {
         blocking = true;
     }
     void flush() {
-        cv.notify_all();
+        waiter.notifyAll();
     }
     static unsigned char *trace(void *data, unsigned char *buffer) {
         return reinterpret_cast<WorkQueue<T, capacity> *>(data)->traceInternal(buffer);
@@ -531,13 +727,25 @@ private:
             traceNbr(value / 10, buffer);
         *(buffer++) = '0' + value % 10;
     }
+    // Reserve up to size slots, only reading the shared count once the known free slots are exhausted
+    inline unsigned short reserve(unsigned short size) {
+        if (writeFree < size)
+            writeFree = capacity - count;
+        if (size > writeFree)
+            size = writeFree;
+        writeFree -= size;
+        return size;
+    }
     T datas[capacity + nbWorker];
-    std::atomic<unsigned short> readIdx;
-    unsigned short writeIdx;
-    std::atomic<unsigned short> count;
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<unsigned short> readIdx; // Consumer side
+    // Producer side
+    alignas(SAFEQUEUE_CACHE_LINE) unsigned short writeIdx;
+    unsigned short writeFree = 0; // Lower bound of the free slots, as workers only release slots
+    // Shared
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<unsigned short> count;
     std::atomic<int> vcount;
-    std::condition_variable cv;
-    bool blocking = true;
+    AtomicWaiter waiter; // Parking of the workers when empty
+    std::atomic<bool> blocking = true;
 };
 
 // Thread-safe blocking-pop queue for work dispatch (worker thread) (maximal capacity of 65536 - nbWorker elements)
@@ -557,7 +765,33 @@ public:
         ++master.vcount;
         if (!master.blocking)
             return false;
-        master.cv.wait(lock);
+        lock.unlock();
+        master.waiter.wait([this]{return master.vcount > 0 || !master.blocking;});
+        lock.lock();
+        goto BEGIN;
+    }
+    // Extract up to size elements from queue with a single reservation
+    // return the number of extracted elements, only 0 if non-blocking
+    unsigned short popBatch(T *data, unsigned short size) {
+        int avail = master.vcount.load(std::memory_order_relaxed);
+        int reserved;
+        BEGIN:
+        if (avail > 0) {
+            reserved = std::min<int>(size, avail);
+            if (!master.vcount.compare_exchange_weak(avail, avail - reserved))
+                goto BEGIN;
+            const unsigned short base = master.readIdx.fetch_add(reserved);
+            for (int i = 0; i < reserved; ++i)
+                data[i] = std::move(master.datas[(unsigned short) (base + 1 + i) % (capacity + nbWorker)]);
+            master.count -= reserved;
+            return reserved;
+        }
+        if (!master.blocking)
+            return 0;
+        lock.unlock();
+        master.waiter.wait([this]{return master.vcount > 0 || !master.blocking;});
+        lock.lock();
+        avail = master.vcount.load(std::memory_order_relaxed);
         goto BEGIN;
     }
     // Wait for the queue to complete operations, or wait for .release()
@@ -566,7 +800,7 @@ public:
         mtx.lock();
         if (master.count && master.blocking) {
             mtx.unlock();
-            master.cv.notify_all();
+            master.waiter.notifyAll();
             std::this_thread::sleep_for(std::chrono::microseconds(100));
             goto WAIT_JOIN;
         }
@@ -596,4 +830,125 @@ private:
     std::unique_lock<std::mutex> lock;
 };
 
+// Lock-free unbounded queue for insertion, with a single consumer (like WorkQueue)
+// Elements are stored in segments of segmentSize elements, which are linked on demand and recycled once consumed
+// Up to maxFreeSegments consumed segments are kept for reuse, the others are released
+// segmentSize MUST be a (power-of-two - 1)
+template<class T, unsigned short segmentSize = 255, unsigned short maxFreeSegments = 4>
+class UnboundedQueue {
+    static_assert(segmentSize && !(segmentSize & (segmentSize + 1)), "segmentSize must be a (power-of-two - 1)");
+public:
+    UnboundedQueue() : tailIdx(0), freeCount(0) {
+        readSeg = new Segment();
+        tailSeg.store(readSeg, std::memory_order_relaxed);
+    }
+    ~UnboundedQueue() {
+        while (readSeg) {
+            Segment *next = readSeg->next.load(std::memory_order_relaxed);
+            delete readSeg;
+            readSeg = next;
+        }
+        Segment *seg = freeSeg.load(std::memory_order_relaxed);
+        while (seg) {
+            Segment *next = seg->nextFree;
+            delete seg;
+            seg = next;
+        }
+    }
+    // Insert element to thread-safe queue, never fail
+    void push(T &data) {
+        insert(std::move(data));
+    }
+    void emplace(const T &data) {
+        insert(data);
+    }
+    // Extract element from queue, return true on success
+    // Must not be called concurrently to another pop
+    bool pop(T &data) {
+        if (!readSeg->ready[readIdx].load(std::memory_order_acquire))
+            return false; // Empty, or the next element is not fully inserted yet
+        data = std::move(readSeg->data[readIdx]);
+        readSeg->ready[readIdx].store(false, std::memory_order_relaxed);
+        if (++readIdx == segmentSize) {
+            // The last slot is only published once the next segment is linked
+            Segment *next = readSeg->next.load(std::memory_order_acquire);
+            recycle(readSeg);
+            readSeg = next;
+            readIdx = 0;
+        }
+        return true;
+    }
+    bool empty() const {
+        return !readSeg->ready[readIdx].load(std::memory_order_acquire);
+    }
+private:
+    struct Segment {
+        Segment() {
+            for (auto &r : ready)
+                r.store(false, std::memory_order_relaxed);
+        }
+        std::atomic<Segment *> next{nullptr};
+        Segment *nextFree; // Link in the free-list
+        std::atomic<bool> ready[segmentSize];
+        T data[segmentSize];
+    };
+    template<class U>
+    void insert(U &&data) {
+        uint64_t idx = tailIdx.load(std::memory_order_acquire);
+        while (true) {
+            const unsigned short offset = idx & segmentSize;
+            if (offset == segmentSize) {
+                // The producer which took the last slot is linking the next segment
+                std::this_thread::yield();
+                idx = tailIdx.load(std::memory_order_acquire);
+                continue;
+            }
+            // Only dereferenced if tailIdx is unchanged, so it can't be a recycled segment
+            Segment *seg = tailSeg.load(std::memory_order_acquire);
+            if (tailIdx.compare_exchange_weak(idx, idx + 1, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                if (offset + 1 == segmentSize) {
+                    Segment *next = acquireSegment();
+                    seg->next.store(next, std::memory_order_release);
+                    tailSeg.store(next, std::memory_order_release);
+                    tailIdx.store((idx | segmentSize) + 1, std::memory_order_release);
+                }
+                seg->data[offset] = std::forward<U>(data);
+                seg->ready[offset].store(true, std::memory_order_release);
+                return;
+            }
+        }
+    }
+    // Called by a single producer at a time, the one linking the next segment
+    Segment *acquireSegment() {
+        Segment *seg = freeSeg.load(std::memory_order_acquire);
+        // No ABA, as the consumer only push segments
+        while (seg && !freeSeg.compare_exchange_weak(seg, seg->nextFree, std::memory_order_acquire))
+            ;
+        if (!seg)
+            return new Segment();
+        freeCount.fetch_sub(1, std::memory_order_relaxed);
+        seg->next.store(nullptr, std::memory_order_relaxed);
+        return seg;
+    }
+    void recycle(Segment *seg) {
+        if (freeCount.load(std::memory_order_relaxed) >= maxFreeSegments) {
+            delete seg;
+            return;
+        }
+        freeCount.fetch_add(1, std::memory_order_relaxed);
+        seg->nextFree = freeSeg.load(std::memory_order_relaxed);
+        while (!freeSeg.compare_exchange_weak(seg->nextFree, seg, std::memory_order_release, std::memory_order_relaxed))
+            ;
+    }
+    // Consumer side
+    alignas(SAFEQUEUE_CACHE_LINE) Segment *readSeg;
+    unsigned short readIdx = 0;
+    // Producer side, the low bits of tailIdx are the offset in tailSeg, segmentSize while linking the next segment
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<uint64_t> tailIdx;
+    std::atomic<Segment *> tailSeg;
+    // Free-list
+    alignas(SAFEQUEUE_CACHE_LINE) std::atomic<Segment *> freeSeg{nullptr};
+    std::atomic<unsigned short> freeCount;
+};
+
 #endif /* SAFEQUEUE_HPP_ */